@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../types.h"
+
+#include <cstdio>
+
+#pragma region Helper functions
+// Vertex always carries uvs and normals; an all zero attribute means the source had none.
+static void detectVertexAttributes(const Mesh& mesh, bool& hasTexCoords, bool& hasNormals)
+{
+    hasTexCoords = false;
+    hasNormals = false;
+
+    for (const Vertex& v : mesh.vertices)
+    {
+        hasTexCoords |= v.textureCoords.x != 0.0f || v.textureCoords.y != 0.0f;
+        hasNormals |= v.normals.x != 0.0f || v.normals.y != 0.0f || v.normals.z != 0.0f;
+        if (hasTexCoords && hasNormals) break;
+    }
+}
+
+// Opens a file for large block writes; the callers keep their own big buffers, so stdio buffering
+// would only add a copy.
+static std::FILE* openExportFile(const std::string& path)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file) std::setvbuf(file, nullptr, _IONBF, 0);
+    return file;
+}
+#pragma endregion
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "export_common.h"
+#include "../Utils/parallelFor.h"
+
+#include <charconv>
+
+#pragma region Helper functions
+// Longest line any section can produce: "vn " and three shortest round trip floats, or a triangle of
+// "i/i/i" corners with 10 digit indices.
+const size_t objWriterMaxLine = 128;
+const size_t objWriterBatchLines = 1 << 15;
+
+enum class ObjSection { Positions, TexCoords, Normals, Faces };
+
+struct ObjWriteJob
+{
+    ObjSection section;
+    size_t begin;
+    size_t end;
+};
+
+static inline char* writeObjFloat(char* out, float value)
+{
+    return std::to_chars(out, out + 32, value).ptr;
+}
+
+static inline char* writeObjIndex(char* out, size_t value)
+{
+    return std::to_chars(out, out + 24, value).ptr;
+}
+
+template <typename Index>
+static char* writeObjFaces(char* out, const Index* indices, size_t begin, size_t end, bool hasTexCoords, bool hasNormals)
+{
+    for (size_t t = begin; t < end; ++t)
+    {
+        *out++ = 'f';
+
+        for (size_t c = 0; c < 3; ++c)
+        {
+            size_t index = (size_t)indices[t * 3 + c] + 1;
+
+            *out++ = ' ';
+            out = writeObjIndex(out, index);
+
+            if (hasTexCoords || hasNormals)
+            {
+                *out++ = '/';
+                if (hasTexCoords) out = writeObjIndex(out, index);
+            }
+
+            if (hasNormals)
+            {
+                *out++ = '/';
+                out = writeObjIndex(out, index);
+            }
+        }
+
+        *out++ = '\n';
+    }
+
+    return out;
+}
+
+static void formatObjJob(const Mesh& mesh, const ObjWriteJob& job, bool hasTexCoords, bool hasNormals, std::vector<char>& buffer)
+{
+    buffer.resize((job.end - job.begin) * objWriterMaxLine);
+    char* out = buffer.data();
+
+    for (size_t i = job.begin; i < job.end && job.section != ObjSection::Faces; ++i)
+    {
+        const Vertex& v = mesh.vertices[i];
+
+        switch (job.section)
+        {
+            case ObjSection::Positions:
+                *out++ = 'v'; *out++ = ' ';
+                out = writeObjFloat(out, v.pos.x); *out++ = ' ';
+                out = writeObjFloat(out, v.pos.y); *out++ = ' ';
+                out = writeObjFloat(out, v.pos.z);
+                break;
+            case ObjSection::TexCoords:
+                *out++ = 'v'; *out++ = 't'; *out++ = ' ';
+                out = writeObjFloat(out, v.textureCoords.x); *out++ = ' ';
+                out = writeObjFloat(out, v.textureCoords.y);
+                break;
+            default:
+                *out++ = 'v'; *out++ = 'n'; *out++ = ' ';
+                out = writeObjFloat(out, v.normals.x); *out++ = ' ';
+                out = writeObjFloat(out, v.normals.y); *out++ = ' ';
+                out = writeObjFloat(out, v.normals.z);
+                break;
+        }
+
+        *out++ = '\n';
+    }
+
+    if (job.section == ObjSection::Faces)
+    {
+        mesh.visitIndices([&](const auto* indices, size_t)
+        {
+            out = writeObjFaces(out, indices, job.begin, job.end, hasTexCoords, hasNormals);
+        });
+    }
+
+    buffer.resize(out - buffer.data());
+}
+#pragma endregion
+
+// Writes a mesh as OBJ with one v/vt/vn per vertex and triangles referencing them. Floats use the
+// shortest representation that reads back to the same value. Lines are formatted in batches into
+// large buffers, optionally on several threads at once, and each batch goes out in a single fwrite.
+// Returns the number of bytes written, 0 on failure.
+static size_t writeObj(const Mesh& mesh, const std::string& path, bool parallel = false)
+{
+    bool hasTexCoords, hasNormals;
+    detectVertexAttributes(mesh, hasTexCoords, hasNormals);
+
+    std::vector<ObjWriteJob> jobs;
+    auto addJobs = [&](ObjSection section, size_t count)
+    {
+        for (size_t begin = 0; begin < count; begin += objWriterBatchLines)
+        {
+            jobs.push_back({ section, begin, std::min(count, begin + objWriterBatchLines) });
+        }
+    };
+
+    addJobs(ObjSection::Positions, mesh.vertices.size());
+    if (hasTexCoords) addJobs(ObjSection::TexCoords, mesh.vertices.size());
+    if (hasNormals) addJobs(ObjSection::Normals, mesh.vertices.size());
+    addJobs(ObjSection::Faces, mesh.indexCount() / 3);
+
+    std::FILE* file = openExportFile(path);
+    if (!file)
+    {
+        return 0;
+    }
+
+    size_t round = parallel ? std::max<size_t>(1, std::thread::hardware_concurrency()) : 1;
+    std::vector<std::vector<char>> buffers(round);
+    size_t written = 0;
+    bool ok = true;
+
+    for (size_t first = 0; first < jobs.size() && ok; first += round)
+    {
+        size_t count = std::min(round, jobs.size() - first);
+
+        parallelFor(count, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t j = begin; j < end; ++j)
+            {
+                formatObjJob(mesh, jobs[first + j], hasTexCoords, hasNormals, buffers[j]);
+            }
+        });
+
+        for (size_t j = 0; j < count && ok; ++j)
+        {
+            ok = std::fwrite(buffers[j].data(), 1, buffers[j].size(), file) == buffers[j].size();
+            written += buffers[j].size();
+        }
+    }
+
+    ok &= std::fclose(file) == 0;
+    return ok ? written : 0;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "export_common.h"
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+
+#pragma region Helper functions
+const size_t plyWriterBatchBytes = 1 << 20;
+
+// Face records are a uchar corner count and three uint32 indices, 13 bytes with no padding.
+const size_t plyFaceBytes = 1 + 3 * sizeof(uint32_t);
+
+template <typename Index>
+static bool writePlyFaces(std::FILE* file, const Index* indices, size_t faceCount, std::vector<char>& buffer, size_t& written)
+{
+    size_t facesPerBatch = plyWriterBatchBytes / plyFaceBytes;
+    buffer.resize(facesPerBatch * plyFaceBytes);
+
+    for (size_t first = 0; first < faceCount; first += facesPerBatch)
+    {
+        size_t count = std::min(facesPerBatch, faceCount - first);
+        char* out = buffer.data();
+
+        for (size_t f = first; f < first + count; ++f)
+        {
+            uint32_t corners[3] = { (uint32_t)indices[f * 3], (uint32_t)indices[f * 3 + 1], (uint32_t)indices[f * 3 + 2] };
+            *out++ = 3;
+            std::memcpy(out, corners, sizeof(corners));
+            out += sizeof(corners);
+        }
+
+        size_t bytes = out - buffer.data();
+        if (std::fwrite(buffer.data(), 1, bytes, file) != bytes) return false;
+        written += bytes;
+    }
+
+    return true;
+}
+
+// ASCII body: one "x y z [nx ny nz] [s t]" line per vertex and one "3 a b c" line per face.
+static bool writePlyAscii(std::FILE* file, const Mesh& mesh, size_t faceCount, bool hasTexCoords, bool hasNormals, size_t& written)
+{
+    const size_t maxLine = 160;
+    std::vector<char> buffer(plyWriterBatchBytes + maxLine);
+    char* out = buffer.data();
+
+    auto flush = [&](bool force)
+    {
+        if (!force && out < buffer.data() + plyWriterBatchBytes) return true;
+
+        size_t bytes = out - buffer.data();
+        written += bytes;
+        out = buffer.data();
+        return std::fwrite(buffer.data(), 1, bytes, file) == bytes;
+    };
+
+    auto number = [&](float value, char separator)
+    {
+        out = std::to_chars(out, out + 32, value).ptr;
+        *out++ = separator;
+    };
+
+    bool ok = true;
+
+    for (size_t i = 0; i < mesh.vertices.size() && ok; ++i)
+    {
+        const Vertex& v = mesh.vertices[i];
+        number(v.pos.x, ' '); number(v.pos.y, ' '); number(v.pos.z, ' ');
+        if (hasNormals) { number(v.normals.x, ' '); number(v.normals.y, ' '); number(v.normals.z, ' '); }
+        if (hasTexCoords) { number(v.textureCoords.x, ' '); number(v.textureCoords.y, ' '); }
+        out[-1] = '\n';
+        ok = flush(false);
+    }
+
+    mesh.visitIndices([&](const auto* indices, size_t)
+    {
+        for (size_t f = 0; f < faceCount && ok; ++f)
+        {
+            *out++ = '3';
+            for (size_t c = 0; c < 3; ++c)
+            {
+                *out++ = ' ';
+                out = std::to_chars(out, out + 24, (uint32_t)indices[f * 3 + c]).ptr;
+            }
+            *out++ = '\n';
+            ok = flush(false);
+        }
+    });
+
+    return ok && flush(true);
+}
+#pragma endregion
+
+// Writes a mesh as binary little endian PLY: x y z, then nx ny nz and s t when the mesh has them.
+// When it has both, the vertex element has exactly the layout of Vertex and the vertex array goes to
+// disk in a single write; otherwise only the wanted attributes are gathered, a batch at a time.
+// With ascii set the same elements are written as text instead. Returns the number of bytes written,
+// 0 on failure.
+static size_t writePly(const Mesh& mesh, const std::string& path, bool ascii = false)
+{
+    static_assert(sizeof(Vertex) == 8 * sizeof(float) && offsetof(Vertex, normals) == 12 && offsetof(Vertex, textureCoords) == 24,
+        "Vertex is written to PLY as eight packed floats");
+
+    bool hasTexCoords, hasNormals;
+    detectVertexAttributes(mesh, hasTexCoords, hasNormals);
+
+    size_t faceCount = mesh.indexCount() / 3;
+
+    std::string header = ascii ? "ply\nformat ascii 1.0\n" : "ply\nformat binary_little_endian 1.0\n";
+    header += "comment ObjLoaderBenchmark\n";
+    header += "element vertex " + std::to_string(mesh.vertices.size()) + "\n";
+    header += "property float x\nproperty float y\nproperty float z\n";
+    if (hasNormals) header += "property float nx\nproperty float ny\nproperty float nz\n";
+    if (hasTexCoords) header += "property float s\nproperty float t\n";
+    header += "element face " + std::to_string(faceCount) + "\n";
+    header += "property list uchar uint vertex_indices\nend_header\n";
+
+    std::FILE* file = openExportFile(path);
+    if (!file)
+    {
+        return 0;
+    }
+
+    size_t written = header.size();
+    bool ok = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+
+    std::vector<char> buffer;
+
+    if (ascii)
+    {
+        ok = ok && writePlyAscii(file, mesh, faceCount, hasTexCoords, hasNormals, written);
+        ok &= std::fclose(file) == 0;
+        return ok ? written : 0;
+    }
+
+    if (ok && hasNormals && hasTexCoords)
+    {
+        size_t bytes = mesh.vertices.size() * sizeof(Vertex);
+        ok = std::fwrite(mesh.vertices.data(), 1, bytes, file) == bytes;
+        written += bytes;
+    }
+    else if (ok)
+    {
+        size_t floatsPerVertex = 3 + (hasNormals ? 3 : 0) + (hasTexCoords ? 2 : 0);
+        size_t verticesPerBatch = plyWriterBatchBytes / (floatsPerVertex * sizeof(float));
+        buffer.resize(verticesPerBatch * floatsPerVertex * sizeof(float));
+
+        for (size_t first = 0; first < mesh.vertices.size() && ok; first += verticesPerBatch)
+        {
+            size_t count = std::min(verticesPerBatch, mesh.vertices.size() - first);
+            float* out = (float*)buffer.data();
+
+            for (size_t i = first; i < first + count; ++i)
+            {
+                const Vertex& v = mesh.vertices[i];
+                *out++ = v.pos.x; *out++ = v.pos.y; *out++ = v.pos.z;
+                if (hasNormals) { *out++ = v.normals.x; *out++ = v.normals.y; *out++ = v.normals.z; }
+                if (hasTexCoords) { *out++ = v.textureCoords.x; *out++ = v.textureCoords.y; }
+            }
+
+            size_t bytes = (char*)out - buffer.data();
+            ok = std::fwrite(buffer.data(), 1, bytes, file) == bytes;
+            written += bytes;
+        }
+    }
+
+    if (ok)
+    {
+        mesh.visitIndices([&](const auto* indices, size_t)
+        {
+            ok = writePlyFaces(file, indices, faceCount, buffer, written);
+        });
+    }
+
+    ok &= std::fclose(file) == 0;
+    return ok ? written : 0;
+}
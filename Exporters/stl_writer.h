@@ -0,0 +1,87 @@
+#pragma once
+
+#include "export_common.h"
+
+#include <cstring>
+
+#pragma region Helper functions
+const size_t stlHeaderBytes = 80;
+const size_t stlTriangleBytes = 50; // normal, three corners, uint16 attribute count
+const size_t stlWriterBatchTriangles = (1 << 20) / stlTriangleBytes;
+
+template <typename Index>
+static bool writeStlTriangles(std::FILE* file, const Mesh& mesh, const Index* indices, size_t triangleCount, size_t& written)
+{
+    std::vector<char> buffer(std::min(stlWriterBatchTriangles, triangleCount) * stlTriangleBytes);
+
+    for (size_t first = 0; first < triangleCount; first += stlWriterBatchTriangles)
+    {
+        size_t count = std::min(stlWriterBatchTriangles, triangleCount - first);
+        char* out = buffer.data();
+
+        for (size_t t = first; t < first + count; ++t)
+        {
+            const vec3& a = mesh.vertices[indices[t * 3]].pos;
+            const vec3& b = mesh.vertices[indices[t * 3 + 1]].pos;
+            const vec3& c = mesh.vertices[indices[t * 3 + 2]].pos;
+
+            float record[12];
+            vec3 normal = vec3::cross(b - a, c - a).normalized();
+            std::memcpy(record, &normal, sizeof(vec3));
+            std::memcpy(record + 3, &a, sizeof(vec3));
+            std::memcpy(record + 6, &b, sizeof(vec3));
+            std::memcpy(record + 9, &c, sizeof(vec3));
+
+            std::memcpy(out, record, sizeof(record));
+            out[48] = 0;
+            out[49] = 0;
+            out += stlTriangleBytes;
+        }
+
+        size_t bytes = out - buffer.data();
+        if (std::fwrite(buffer.data(), 1, bytes, file) != bytes) return false;
+        written += bytes;
+    }
+
+    return true;
+}
+#pragma endregion
+
+// Writes a mesh as binary STL. STL has no shared vertices, so each triangle's corners are gathered
+// from the vertex array through the index buffer, a batch of triangles per write, together with the
+// facet normal. Returns the number of bytes written, 0 on failure.
+static size_t writeStl(const Mesh& mesh, const std::string& path)
+{
+    static_assert(sizeof(vec3) == 3 * sizeof(float), "vec3 is written to STL as three packed floats");
+
+    size_t triangleCount = mesh.indexCount() / 3;
+    if (triangleCount > 0xffffffffull)
+    {
+        return 0;
+    }
+
+    std::FILE* file = openExportFile(path);
+    if (!file)
+    {
+        return 0;
+    }
+
+    char header[stlHeaderBytes + sizeof(uint32_t)] = {};
+    std::strncpy(header, "binary STL written by ObjLoaderBenchmark", stlHeaderBytes);
+    uint32_t count = (uint32_t)triangleCount;
+    std::memcpy(header + stlHeaderBytes, &count, sizeof(count));
+
+    size_t written = sizeof(header);
+    bool ok = std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+
+    if (ok)
+    {
+        mesh.visitIndices([&](const auto* indices, size_t)
+        {
+            ok = writeStlTriangles(file, mesh, indices, triangleCount, written);
+        });
+    }
+
+    ok &= std::fclose(file) == 0;
+    return ok ? written : 0;
+}
@@ -1,2 +1,11 @@
+#include <stddef.h>
+
+/* fast_obj allocates through these, defined with the operator new hook in Utils/allocationHook.h so
+   its arrays are counted like every other loader's. */
+void* countedRealloc(void* pointer, size_t size);
+void countedFree(void* pointer);
+
+#define FAST_OBJ_REALLOC countedRealloc
+#define FAST_OBJ_FREE countedFree
 #define FAST_OBJ_IMPLEMENTATION
-#include "fast_obj.h"
\ No newline at end of file
+#include "fast_obj.h"
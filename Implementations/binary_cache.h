@@ -0,0 +1,399 @@
+#pragma once
+
+#include "loader_template.h"
+#include "new_fast.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+#pragma region Binary mesh format
+// Layout: header, then the vertex, index, smoothing group and submesh blobs, each starting on a 64 byte
+// boundary so the mapped pointers can be used directly as Vertex* / unsigned int*. The submesh blob is
+// one record per submesh followed by all names back to back, then the 'mtllib' names of the material
+// library, each ended by a newline, so a cache hit can load the same materials a text parse would.
+// The source fields describe the OBJ and loader options the file was built from, zero when unknown.
+const uint32_t binaryMeshMagic = 0x48534D4F; // "OMSH"
+const uint32_t binaryMeshVersion = 5;
+const uint64_t binaryMeshAlignment = 64;
+
+struct BinaryMeshHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexStride;
+    uint32_t indexStride;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t smoothingGroupCount;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t smoothingGroupOffset;
+    uint64_t submeshCount;
+    uint64_t submeshOffset;
+    uint64_t materialLibraryBytes;
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    uint64_t sourceOptionsHash;
+    uint64_t fileSize;
+};
+
+// Size and modification time of the OBJ a cache file was built from, and the loader options it used.
+struct BinaryMeshSource
+{
+    uint64_t size = 0;
+    int64_t modified = 0;
+    uint64_t optionsHash = 0;
+
+    bool operator==(const BinaryMeshSource& other) const
+    {
+        return size == other.size && modified == other.modified && optionsHash == other.optionsHash;
+    }
+};
+
+struct BinarySubmeshRecord
+{
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint32_t objectLength;
+    uint32_t groupLength;
+    uint32_t materialLength;
+    uint32_t padding;
+};
+
+#pragma region Helper functions
+static inline uint64_t mixHash(uint64_t h, uint64_t v)
+{
+    h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    h *= 0xFF51AFD7ED558CCDull;
+    return h ^ (h >> 33);
+}
+
+// Word at a time hash of a byte range, fast enough to run over every input file on each load.
+static uint64_t hashBytes(const char* data, size_t size)
+{
+    uint64_t h = 0xCBF29CE484222325ull ^ size;
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32)
+    {
+        uint64_t w[4];
+        std::memcpy(w, data + i, sizeof(w));
+        h = mixHash(mixHash(mixHash(mixHash(h, w[0]), w[1]), w[2]), w[3]);
+    }
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t w;
+        std::memcpy(&w, data + i, sizeof(w));
+        h = mixHash(h, w);
+    }
+
+    uint64_t tail = 0;
+    if (size > i) std::memcpy(&tail, data + i, size - i);
+    return mixHash(h, tail);
+}
+
+static uint64_t hashString(const std::string& s)
+{
+    return hashBytes(s.data(), s.size());
+}
+
+// Everything besides the file contents that changes what a loader produces.
+static uint64_t loaderOptionsHash(const LoaderTemplate& loader)
+{
+    uint64_t h = hashString(loader.Name());
+    h = mixHash(h, deduplicateVertices ? 1 : 0);
+    h = mixHash(h, (uint64_t)triangulationMode);
+    h = mixHash(h, sizeof(Vertex));
+    return mixHash(h, binaryMeshVersion);
+}
+#pragma endregion
+
+static inline uint64_t alignBinaryOffset(uint64_t offset)
+{
+    return (offset + binaryMeshAlignment - 1) & ~(binaryMeshAlignment - 1);
+}
+
+// False when the file cannot be stat'ed.
+static bool binaryMeshSource(const std::string& filename, uint64_t optionsHash, BinaryMeshSource& source)
+{
+    std::error_code error;
+    source.size = std::filesystem::file_size(filename, error);
+    if (error) return false;
+
+    source.modified = (int64_t)std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+    source.optionsHash = optionsHash;
+    return !error;
+}
+
+static bool writeBinaryMesh(const std::string& path, const Mesh& mesh, const BinaryMeshSource& source = BinaryMeshSource())
+{
+    BinaryMeshHeader header{};
+    header.magic = binaryMeshMagic;
+    header.version = binaryMeshVersion;
+    header.vertexStride = sizeof(Vertex);
+    header.indexStride = sizeof(unsigned int);
+    header.vertexCount = mesh.vertices.size();
+    header.indexCount = mesh.indexCount();
+    header.smoothingGroupCount = mesh.smoothingGroups.size();
+    header.vertexOffset = alignBinaryOffset(sizeof(BinaryMeshHeader));
+    header.indexOffset = alignBinaryOffset(header.vertexOffset + header.vertexCount * sizeof(Vertex));
+    header.smoothingGroupOffset = alignBinaryOffset(header.indexOffset + header.indexCount * sizeof(unsigned int));
+    header.submeshCount = mesh.submeshes.size();
+    header.submeshOffset = alignBinaryOffset(header.smoothingGroupOffset + header.smoothingGroupCount * sizeof(unsigned int));
+
+    // The file always stores 32 bit indices, so a mesh packed to 16 bits is widened on the way out.
+    std::vector<unsigned int> widenedIndices;
+    const unsigned int* indexData = nullptr;
+    mesh.visitIndices([&](const auto* indices, size_t count)
+    {
+        if constexpr (sizeof(*indices) == sizeof(unsigned int))
+        {
+            indexData = indices;
+        }
+        else
+        {
+            widenedIndices.assign(indices, indices + count);
+            indexData = widenedIndices.data();
+        }
+    });
+
+    std::vector<BinarySubmeshRecord> submeshRecords;
+    std::string submeshNames;
+    for (const Submesh& submesh : mesh.submeshes)
+    {
+        submeshRecords.push_back({ submesh.indexOffset, submesh.indexCount,
+            (uint32_t)submesh.object.size(), (uint32_t)submesh.group.size(), (uint32_t)submesh.material.size(), 0 });
+        submeshNames += submesh.object + submesh.group + submesh.material;
+    }
+
+    std::string materialLibraries;
+    if (mesh.materials)
+    {
+        for (const std::string& source : mesh.materials->sources) materialLibraries += source + "\n";
+    }
+
+    header.materialLibraryBytes = materialLibraries.size();
+    header.sourceSize = source.size;
+    header.sourceModified = source.modified;
+    header.sourceOptionsHash = source.optionsHash;
+    header.fileSize = header.submeshOffset + submeshRecords.size() * sizeof(BinarySubmeshRecord) + submeshNames.size() + materialLibraries.size();
+
+    // Write next to the target and rename, so a reader never maps a half written file.
+    std::string tempPath = path + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        return false;
+    }
+
+    static const char padding[binaryMeshAlignment] = {};
+    auto writeBlob = [&](uint64_t offset, const void* data, size_t bytes)
+    {
+        out.write(padding, (std::streamsize)(offset - (uint64_t)out.tellp()));
+        if (bytes) out.write((const char*)data, (std::streamsize)bytes);
+    };
+
+    out.write((const char*)&header, sizeof(header));
+    writeBlob(header.vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+    writeBlob(header.indexOffset, indexData, header.indexCount * sizeof(unsigned int));
+    writeBlob(header.smoothingGroupOffset, mesh.smoothingGroups.data(), mesh.smoothingGroups.size() * sizeof(unsigned int));
+    writeBlob(header.submeshOffset, submeshRecords.data(), submeshRecords.size() * sizeof(BinarySubmeshRecord));
+    out.write(submeshNames.data(), (std::streamsize)submeshNames.size());
+    out.write(materialLibraries.data(), (std::streamsize)materialLibraries.size());
+    out.close();
+
+    if (!out)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::remove(path.c_str());
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+#pragma endregion
+
+// Read-only view of a binary mesh file. The arrays point straight into the mapping, nothing is parsed
+// or copied; the view keeps the mapping alive for as long as it exists.
+struct BinaryMeshView
+{
+    std::unique_ptr<MappedFile> file;
+    const BinaryMeshHeader* header = nullptr;
+    const Vertex* vertices = nullptr;
+    const unsigned int* indices = nullptr;
+    const unsigned int* smoothingGroups = nullptr;
+    const BinarySubmeshRecord* submeshes = nullptr;
+    const char* submeshNames = nullptr;
+    const char* materialLibraryNames = nullptr;
+
+    bool open(const std::string& path)
+    {
+        file.reset(new MappedFile());
+        if (!file->open(path) || file->size < sizeof(BinaryMeshHeader))
+        {
+            file.reset();
+            return false;
+        }
+
+        header = (const BinaryMeshHeader*)file->data;
+
+        bool valid = header->magic == binaryMeshMagic
+            && header->version == binaryMeshVersion
+            && header->vertexStride == sizeof(Vertex)
+            && header->indexStride == sizeof(unsigned int)
+            && header->fileSize == file->size
+            && header->vertexOffset + header->vertexCount * sizeof(Vertex) <= header->indexOffset
+            && header->indexOffset + header->indexCount * sizeof(unsigned int) <= header->smoothingGroupOffset
+            && header->smoothingGroupOffset + header->smoothingGroupCount * sizeof(unsigned int) <= header->submeshOffset
+            && header->submeshOffset + header->submeshCount * sizeof(BinarySubmeshRecord) <= file->size;
+
+        if (!valid)
+        {
+            header = nullptr;
+            file.reset();
+            return false;
+        }
+
+        vertices = (const Vertex*)(file->data + header->vertexOffset);
+        indices = (const unsigned int*)(file->data + header->indexOffset);
+        smoothingGroups = (const unsigned int*)(file->data + header->smoothingGroupOffset);
+        submeshes = (const BinarySubmeshRecord*)(file->data + header->submeshOffset);
+        submeshNames = (const char*)(submeshes + header->submeshCount);
+
+        // The names take up exactly the rest of the file.
+        uint64_t nameBytes = 0;
+        for (size_t i = 0; i < header->submeshCount; ++i)
+        {
+            nameBytes += (uint64_t)submeshes[i].objectLength + submeshes[i].groupLength + submeshes[i].materialLength;
+        }
+
+        materialLibraryNames = submeshNames + nameBytes;
+        if (materialLibraryNames + header->materialLibraryBytes != file->data + file->size)
+        {
+            header = nullptr;
+            file.reset();
+            return false;
+        }
+
+        return true;
+    }
+
+    size_t vertexCount() const { return header ? (size_t)header->vertexCount : 0; }
+    size_t indexCount() const { return header ? (size_t)header->indexCount : 0; }
+    size_t smoothingGroupCount() const { return header ? (size_t)header->smoothingGroupCount : 0; }
+    size_t submeshCount() const { return header ? (size_t)header->submeshCount : 0; }
+
+    BinaryMeshSource source() const
+    {
+        BinaryMeshSource source;
+        if (header)
+        {
+            source.size = header->sourceSize;
+            source.modified = header->sourceModified;
+            source.optionsHash = header->sourceOptionsHash;
+        }
+        return source;
+    }
+
+    // The 'mtllib' names the mesh was parsed with, for loadMaterialLibraries.
+    std::vector<std::string> materialLibraries() const
+    {
+        std::vector<std::string> names;
+        if (!header) return names;
+
+        const char* p = materialLibraryNames;
+        const char* end = p + header->materialLibraryBytes;
+        while (p < end)
+        {
+            const char* newline = std::find(p, end, '\n');
+            names.emplace_back(p, newline);
+            p = newline + 1;
+        }
+
+        return names;
+    }
+
+    // Owning copy for code that needs a Mesh; a plain memcpy of each blob.
+    Mesh toMesh() const
+    {
+        Mesh mesh;
+        mesh.vertices.assign(vertices, vertices + vertexCount());
+        mesh.indices().assign(indices, indices + indexCount());
+        mesh.smoothingGroups.assign(smoothingGroups, smoothingGroups + smoothingGroupCount());
+
+        const char* name = submeshNames;
+        for (size_t i = 0; i < submeshCount(); ++i)
+        {
+            const BinarySubmeshRecord& record = submeshes[i];
+            Submesh submesh{ std::string(name, record.objectLength), std::string(name + record.objectLength, record.groupLength),
+                std::string(name + record.objectLength + record.groupLength, record.materialLength), (size_t)record.indexOffset, (size_t)record.indexCount };
+
+            mesh.submeshes.push_back(submesh);
+            name += record.objectLength + record.groupLength + record.materialLength;
+        }
+
+        return mesh;
+    }
+};
+
+// Serves meshes from a binary cache file next to the OBJ. The first load parses the text with
+// NewFast and writes the cache, every load after that maps the cache instead of parsing. A cache file
+// whose recorded OBJ size, modification time or loader options differ from the current ones is stale
+// and gets rebuilt.
+class BinaryMeshCache : public LoaderTemplate
+{
+private:
+    NewFast textLoader;
+    uint64_t optionsHash = loaderOptionsHash(textLoader);
+
+public:
+    static std::string cachePath(const std::string& filename)
+    {
+        return filename + ".meshcache";
+    }
+
+    const char* Name() const override
+    {
+        return "binary mesh cache";
+    }
+
+    Mesh loadObjImplementation(const std::string& filename) override
+    {
+        BinaryMeshSource source;
+        bool known = binaryMeshSource(filename, optionsHash, source);
+
+        BinaryMeshView view;
+        bool opened;
+        {
+            ScopedPhaseTimer timer(LoadPhase::OpenMap);
+            opened = known && view.open(cachePath(filename)) && view.source() == source;
+        }
+
+        if (opened)
+        {
+            Mesh mesh;
+            {
+                ScopedPhaseTimer timer(LoadPhase::Assembly);
+                mesh = view.toMesh();
+            }
+
+            std::vector<std::string> materialLibraries = view.materialLibraries();
+            if (!materialLibraries.empty()) mesh.materials = loadMaterialLibraries(filename, materialLibraries);
+            return mesh;
+        }
+
+        Mesh mesh = textLoader.loadObjImplementation(filename);
+
+        view = BinaryMeshView();
+        if (known && !writeBinaryMesh(cachePath(filename), mesh, source))
+        {
+            std::cout << "Failed to write mesh cache for " << filename << "\n";
+        }
+
+        return mesh;
+    }
+};
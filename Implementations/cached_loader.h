@@ -0,0 +1,270 @@
+#pragma once
+
+#include "loader_template.h"
+#include "binary_cache.h"
+
+#include <filesystem>
+#include <list>
+#include <map>
+
+// Disk cache in front of any LoaderTemplate. Entries are binary mesh files named after a hash of the
+// OBJ bytes and the loader options, so an edited file or a changed option simply misses and is rebuilt,
+// and the stale entry ages out through LRU eviction. The quick path skips hashing the bytes when the
+// file size and modification time match the last time the file was hashed. The hash index is written
+// back once, when the loader goes away, and the cache directory is only listed on first use; after
+// that its size and LRU order are tracked in memory.
+class CachedLoader : public LoaderTemplate
+{
+private:
+    struct IndexEntry
+    {
+        uint64_t size;
+        int64_t modified;
+        uint64_t contentHash;
+    };
+
+    LoaderTemplate* inner;
+    std::string name;
+    std::filesystem::path directory;
+    uint64_t maxBytes;
+    bool useQuickPath;
+
+    struct CacheFile
+    {
+        uint64_t size;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    std::map<std::string, IndexEntry> index;
+    bool indexLoaded = false;
+    bool indexDirty = false;
+
+    // Entry files by name, least recently used first in lru.
+    std::unordered_map<std::string, CacheFile> cacheFiles;
+    std::list<std::string> lru;
+    uint64_t cacheBytes = 0;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    std::chrono::microseconds hitTime{ 0 };
+    std::chrono::microseconds missTime{ 0 };
+
+    std::filesystem::path indexPath() const
+    {
+        return directory / "index.txt";
+    }
+
+    void loadIndex()
+    {
+        indexLoaded = true;
+
+        std::ifstream in(indexPath());
+        std::string line;
+
+        while (std::getline(in, line))
+        {
+            std::istringstream fields(line);
+            IndexEntry entry;
+            std::string path;
+
+            fields >> entry.size >> entry.modified >> std::hex >> entry.contentHash >> std::dec;
+            std::getline(fields >> std::ws, path);
+
+            if (fields && !path.empty()) index[path] = entry;
+        }
+    }
+
+    void saveIndex()
+    {
+        if (!indexDirty) return;
+        indexDirty = false;
+
+        std::ofstream out(indexPath(), std::ios::trunc);
+
+        for (const auto& it : index)
+        {
+            out << it.second.size << " " << it.second.modified << " " << std::hex << it.second.contentHash << std::dec << " " << it.first << "\n";
+        }
+    }
+
+    bool contentHash(const std::string& filename, uint64_t& hash)
+    {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(filename, error);
+        if (error) return false;
+
+        int64_t modified = (int64_t)std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+        if (error) return false;
+
+        auto it = index.find(filename);
+        if (useQuickPath && it != index.end() && it->second.size == size && it->second.modified == modified)
+        {
+            hash = it->second.contentHash;
+            return true;
+        }
+
+        MappedFile file;
+        if (size > 0 && !file.open(filename)) return false;
+
+        hash = hashBytes(file.data, size > 0 ? file.size : 0);
+        index[filename] = { size, modified, hash };
+        indexDirty = true;
+        return true;
+    }
+
+    // Lists the entries already on disk once, ordered by their last use.
+    void loadCacheFiles()
+    {
+        struct DiskFile
+        {
+            std::string name;
+            std::filesystem::file_time_type lastUse;
+            uint64_t size;
+        };
+
+        std::vector<DiskFile> files;
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+        {
+            if (entry.path().extension() != ".meshcache") continue;
+
+            files.push_back({ entry.path().filename().string(), entry.last_write_time(error), entry.file_size(error) });
+        }
+
+        std::sort(files.begin(), files.end(), [](const DiskFile& a, const DiskFile& b) { return a.lastUse < b.lastUse; });
+
+        for (const DiskFile& file : files)
+        {
+            used(file.name, file.size);
+        }
+    }
+
+    // Marks an entry as the most recently used one; size is only read for entries not tracked yet.
+    void used(const std::string& entryName, uint64_t size)
+    {
+        auto it = cacheFiles.find(entryName);
+        if (it != cacheFiles.end())
+        {
+            lru.splice(lru.end(), lru, it->second.lruPosition);
+            return;
+        }
+
+        cacheFiles[entryName] = { size, lru.insert(lru.end(), entryName) };
+        cacheBytes += size;
+    }
+
+    // Drops least recently used entries until the tracked entries fit in maxBytes again.
+    void evict()
+    {
+        while (cacheBytes > maxBytes && !lru.empty())
+        {
+            std::string entryName = lru.front();
+            lru.pop_front();
+
+            auto it = cacheFiles.find(entryName);
+            cacheBytes -= it->second.size;
+            cacheFiles.erase(it);
+
+            std::error_code error;
+            if (std::filesystem::remove(directory / entryName, error)) evictions++;
+        }
+    }
+
+public:
+    CachedLoader(LoaderTemplate* inner, const std::string& directory = "MeshCache", uint64_t maxBytes = 256ull << 20, bool useQuickPath = true)
+        : inner(inner), name(std::string("cached ") + inner->Name()), directory(directory), maxBytes(maxBytes), useQuickPath(useQuickPath)
+    {}
+
+    ~CachedLoader()
+    {
+        saveIndex();
+    }
+
+    const char* Name() const override
+    {
+        return name.c_str();
+    }
+
+    Mesh loadObjImplementation(const std::string& filename) override
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        if (!indexLoaded)
+        {
+            std::error_code error;
+            std::filesystem::create_directories(directory, error);
+            loadIndex();
+            loadCacheFiles();
+        }
+
+        uint64_t hash = 0;
+        if (!contentHash(filename, hash))
+        {
+            return inner->loadObjImplementation(filename);
+        }
+
+        char key[17];
+        std::snprintf(key, sizeof(key), "%016llx", (unsigned long long)mixHash(hash, loaderOptionsHash(*inner)));
+        std::string entryName = std::string(key) + ".meshcache";
+        std::filesystem::path entryPath = directory / entryName;
+
+        BinaryMeshView view;
+        if (view.open(entryPath.string()))
+        {
+            Mesh mesh = view.toMesh();
+            std::vector<std::string> materialLibraries = view.materialLibraries();
+            view.file.reset();
+
+            if (!materialLibraries.empty()) mesh.materials = loadMaterialLibraries(filename, materialLibraries);
+
+            // The write time doubles as the LRU timestamp; touched after unmapping so Windows allows it.
+            std::error_code error;
+            std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), error);
+            used(entryName, cacheFiles.count(entryName) ? 0 : std::filesystem::file_size(entryPath, error));
+
+            hits++;
+            hitTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+            return mesh;
+        }
+
+        // Missing, truncated or written by another format version: rebuild it.
+        Mesh mesh = inner->loadObjImplementation(filename);
+
+        if (writeBinaryMesh(entryPath.string(), mesh))
+        {
+            std::error_code error;
+            uint64_t size = std::filesystem::file_size(entryPath, error);
+
+            // A rewritten entry replaces the size it had before.
+            auto it = cacheFiles.find(entryName);
+            if (it != cacheFiles.end())
+            {
+                cacheBytes -= it->second.size;
+                lru.erase(it->second.lruPosition);
+                cacheFiles.erase(it);
+            }
+
+            used(entryName, error ? 0 : size);
+            evict();
+        }
+
+        misses++;
+        missTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+        return mesh;
+    }
+
+    MetricList Metrics() const override
+    {
+        size_t lookups = hits + misses;
+
+        return {
+            { "Cache hit rate %", lookups ? 100.0 * hits / lookups : 0.0 },
+            { "Cache miss rate %", lookups ? 100.0 * misses / lookups : 0.0 },
+            { "Avg hit latency us", hits ? (double)hitTime.count() / hits : 0.0 },
+            { "Avg miss latency us", misses ? (double)missTime.count() / misses : 0.0 },
+            { "Cache evictions", (double)evictions }
+        };
+    }
+};
@@ -0,0 +1,642 @@
+#pragma once
+
+#include "../types.h"
+#include "../Utils/traceEvents.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef OBJ_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#pragma region Helper functions
+// Slicing-by-8 CRC-32 (gzip polynomial), eight table lookups per eight input bytes.
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size)
+{
+    static const auto tables = []()
+    {
+        std::vector<uint32_t> t(8 * 256);
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            for (int k = 1; k < 8; ++k) t[k * 256 + i] = (t[(k - 1) * 256 + i] >> 8) ^ t[t[(k - 1) * 256 + i] & 0xff];
+        }
+        return t;
+    }();
+
+    const uint32_t* t = tables.data();
+    crc = ~crc;
+
+    for (; size >= 8; size -= 8, data += 8)
+    {
+        uint32_t one, two;
+        std::memcpy(&one, data, 4);
+        std::memcpy(&two, data + 4, 4);
+        one ^= crc;
+
+        crc = t[7 * 256 + (one & 0xff)] ^ t[6 * 256 + ((one >> 8) & 0xff)] ^ t[5 * 256 + ((one >> 16) & 0xff)] ^ t[4 * 256 + (one >> 24)]
+            ^ t[3 * 256 + (two & 0xff)] ^ t[2 * 256 + ((two >> 8) & 0xff)] ^ t[1 * 256 + ((two >> 16) & 0xff)] ^ t[two >> 24];
+    }
+
+    for (; size; --size, ++data) crc = t[(crc ^ *data) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static inline bool endsWith(const std::string& s, const char* suffix)
+{
+    size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+#pragma endregion
+
+#pragma region Inflate
+// Canonical Huffman code with a single lookup table as wide as its longest code.
+// Entries are (symbol << 4) | length, 0 marks a bit pattern no code maps to.
+struct HuffmanTable
+{
+    std::vector<uint16_t> entries;
+    unsigned bits = 1;
+
+    bool build(const uint8_t* lengths, size_t count)
+    {
+        unsigned lengthCount[16] = {};
+        for (size_t i = 0; i < count; ++i) lengthCount[lengths[i]]++;
+        lengthCount[0] = 0;
+
+        bits = 1;
+        for (unsigned l = 1; l < 16; ++l) if (lengthCount[l]) bits = l;
+
+        unsigned nextCode[16] = {};
+        unsigned code = 0;
+        for (unsigned l = 1; l < 16; ++l)
+        {
+            code = (code + lengthCount[l - 1]) << 1;
+            nextCode[l] = code;
+            if (lengthCount[l] && nextCode[l] + lengthCount[l] > (1u << l)) return false; // over-subscribed
+        }
+
+        entries.assign((size_t)1 << bits, 0);
+
+        for (size_t symbol = 0; symbol < count; ++symbol)
+        {
+            unsigned length = lengths[symbol];
+            if (!length) continue;
+
+            unsigned c = nextCode[length]++;
+            unsigned reversed = 0;
+            for (unsigned b = 0; b < length; ++b) reversed |= ((c >> b) & 1) << (length - 1 - b);
+
+            for (size_t i = reversed; i < entries.size(); i += (size_t)1 << length)
+            {
+                entries[i] = (uint16_t)((symbol << 4) | length);
+            }
+        }
+
+        return true;
+    }
+};
+
+// Raw DEFLATE (RFC 1951) decoder. Output goes through a sliding window and is handed to a sink in
+// large pieces, so a whole file never has to be resident in decompressed form.
+class Inflater
+{
+private:
+    static const size_t windowSize = 32768;
+    static const size_t maxMatch = 258;
+
+    const uint8_t* input;
+    size_t inputSize;
+    size_t inputPos = 0;
+    uint64_t bitBuffer = 0;
+    unsigned bitCount = 0;
+
+    std::vector<uint8_t> output;
+    size_t outputPos = 0;
+    size_t emitted = 0;
+    size_t flushAt;
+
+    HuffmanTable literals;
+    HuffmanTable distances;
+
+    void refill()
+    {
+        if (inputPos + 8 <= inputSize)
+        {
+            uint64_t word;
+            std::memcpy(&word, input + inputPos, sizeof(word));
+            bitBuffer |= word << bitCount;
+            inputPos += (63 - bitCount) >> 3;
+            bitCount |= 56;
+            return;
+        }
+
+        // Past the end reads zeros; position() tells the caller if a stream ran off its input.
+        while (bitCount <= 56)
+        {
+            uint64_t byte = inputPos < inputSize ? input[inputPos] : 0;
+            bitBuffer |= byte << bitCount;
+            inputPos++;
+            bitCount += 8;
+        }
+    }
+
+    unsigned getBits(unsigned n)
+    {
+        if (bitCount < n) refill();
+        unsigned value = (unsigned)(bitBuffer & ((1ull << n) - 1));
+        bitBuffer >>= n;
+        bitCount -= n;
+        return value;
+    }
+
+    int decodeSymbol(const HuffmanTable& table)
+    {
+        if (bitCount < 15) refill();
+        uint16_t entry = table.entries[bitBuffer & ((1ull << table.bits) - 1)];
+        unsigned length = entry & 15;
+        if (!length) return -1;
+
+        bitBuffer >>= length;
+        bitCount -= length;
+        return entry >> 4;
+    }
+
+    template<typename Sink>
+    void flush(Sink& sink, bool keepWindow)
+    {
+        if (outputPos > emitted) sink((const char*)output.data() + emitted, outputPos - emitted);
+        emitted = outputPos;
+
+        if (keepWindow && outputPos > windowSize)
+        {
+            std::memmove(output.data(), output.data() + outputPos - windowSize, windowSize);
+            outputPos = emitted = windowSize;
+        }
+    }
+
+    bool buildFixedTables()
+    {
+        uint8_t lengths[288 + 32];
+        for (int i = 0; i < 144; ++i) lengths[i] = 8;
+        for (int i = 144; i < 256; ++i) lengths[i] = 9;
+        for (int i = 256; i < 280; ++i) lengths[i] = 7;
+        for (int i = 280; i < 288; ++i) lengths[i] = 8;
+        for (int i = 288; i < 320; ++i) lengths[i] = 5;
+
+        return literals.build(lengths, 288) && distances.build(lengths + 288, 32);
+    }
+
+    bool buildDynamicTables()
+    {
+        static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+        unsigned literalCount = getBits(5) + 257;
+        unsigned distanceCount = getBits(5) + 1;
+        unsigned codeLengthCount = getBits(4) + 4;
+        if (literalCount > 286 || distanceCount > 30) return false;
+
+        uint8_t codeLengths[19] = {};
+        for (unsigned i = 0; i < codeLengthCount; ++i) codeLengths[order[i]] = (uint8_t)getBits(3);
+
+        HuffmanTable codeLengthTable;
+        if (!codeLengthTable.build(codeLengths, 19)) return false;
+
+        uint8_t lengths[286 + 30] = {};
+        unsigned total = literalCount + distanceCount;
+
+        for (unsigned i = 0; i < total;)
+        {
+            int symbol = decodeSymbol(codeLengthTable);
+            if (symbol < 0) return false;
+
+            if (symbol < 16)
+            {
+                lengths[i++] = (uint8_t)symbol;
+                continue;
+            }
+
+            uint8_t value = 0;
+            unsigned repeat;
+
+            if (symbol == 16)
+            {
+                if (i == 0) return false;
+                value = lengths[i - 1];
+                repeat = 3 + getBits(2);
+            }
+            else if (symbol == 17)
+            {
+                repeat = 3 + getBits(3);
+            }
+            else
+            {
+                repeat = 11 + getBits(7);
+            }
+
+            if (i + repeat > total) return false;
+            while (repeat--) lengths[i++] = value;
+        }
+
+        if (lengths[256] == 0) return false; // no end of block code
+
+        return literals.build(lengths, literalCount) && distances.build(lengths + literalCount, distanceCount);
+    }
+
+    template<typename Sink>
+    bool inflateBlock(Sink& sink)
+    {
+        static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const uint16_t distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const uint8_t distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        while (true)
+        {
+            if (outputPos >= flushAt) flush(sink, true);
+
+            int symbol = decodeSymbol(literals);
+            if (symbol < 0) return false;
+
+            if (symbol < 256)
+            {
+                output[outputPos++] = (uint8_t)symbol;
+                continue;
+            }
+
+            if (symbol == 256) return true;
+
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            size_t length = lengthBase[symbol] + getBits(lengthExtra[symbol]);
+
+            int distanceSymbol = decodeSymbol(distances);
+            if (distanceSymbol < 0 || distanceSymbol >= 30) return false;
+            size_t distance = distanceBase[distanceSymbol] + getBits(distanceExtra[distanceSymbol]);
+            if (distance > outputPos) return false;
+
+            uint8_t* dst = output.data() + outputPos;
+            const uint8_t* src = dst - distance;
+
+            if (distance >= 8)
+            {
+                // Overshoots by up to 7 bytes, the buffer has slack for it.
+                for (size_t i = 0; i < length; i += 8) std::memcpy(dst + i, src + i, 8);
+            }
+            else
+            {
+                for (size_t i = 0; i < length; ++i) dst[i] = src[i];
+            }
+
+            outputPos += length;
+        }
+    }
+
+    template<typename Sink>
+    bool storedBlock(Sink& sink)
+    {
+        // Drop to the byte boundary, then LEN and NLEN.
+        getBits(bitCount & 7);
+        unsigned length = getBits(16);
+        unsigned complement = getBits(16);
+        if ((length ^ 0xffff) != complement) return false;
+
+        // Hand back whole bytes still sitting in the bit buffer and copy straight from the input.
+        inputPos -= bitCount / 8;
+        bitBuffer = 0;
+        bitCount = 0;
+        if (inputPos + length > inputSize) return false;
+
+        while (length)
+        {
+            if (outputPos >= flushAt) flush(sink, true);
+
+            size_t n = std::min<size_t>(length, output.size() - maxMatch - 8 - outputPos);
+            std::memcpy(output.data() + outputPos, input + inputPos, n);
+            outputPos += n;
+            inputPos += n;
+            length -= (unsigned)n;
+        }
+
+        return true;
+    }
+
+public:
+    Inflater(size_t chunkSize) : flushAt(windowSize + chunkSize)
+    {
+        output.resize(windowSize + chunkSize + maxMatch + 8);
+    }
+
+    // Decodes one DEFLATE stream from data, calling sink(const char*, size_t) with the output.
+    template<typename Sink>
+    bool inflate(const uint8_t* data, size_t size, Sink& sink)
+    {
+        input = data;
+        inputSize = size;
+        inputPos = 0;
+        bitBuffer = 0;
+        bitCount = 0;
+        outputPos = emitted = 0;
+
+        bool last = false;
+
+        while (!last)
+        {
+            last = getBits(1) != 0;
+            unsigned type = getBits(2);
+            bool ok;
+
+            if (type == 0) ok = storedBlock(sink);
+            else if (type == 1) ok = buildFixedTables() && inflateBlock(sink);
+            else if (type == 2) ok = buildDynamicTables() && inflateBlock(sink);
+            else ok = false;
+
+            if (!ok || position() > inputSize) return false;
+        }
+
+        flush(sink, false);
+        return true;
+    }
+
+    // Bytes of input consumed, rounded up to the byte the stream ended in.
+    size_t position() const
+    {
+        return inputPos - bitCount / 8;
+    }
+};
+#pragma endregion
+
+// Decompresses .obj.gz (and .obj.zst when built with OBJ_WITH_ZSTD) on a background thread into a
+// small ring of chunks. The mapped input is paged in by that same thread, so disk reads and
+// decompression both overlap with whatever the caller does with the previous chunk.
+class CompressedObjStream
+{
+private:
+    static const size_t chunkSize = 1 << 20;
+    static const size_t maxQueuedChunks = 3;
+
+    MappedFile file;
+    std::thread producer;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<char>> filled;
+    std::vector<std::vector<char>> spare;
+    bool finished = false;
+    bool cancelled = false;
+    bool error = false;
+
+    size_t expectedSize = 0;
+
+    // Returns false once the reader has gone away.
+    bool push(std::vector<char>& chunk)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return filled.size() < maxQueuedChunks || cancelled; });
+        if (cancelled) return false;
+
+        filled.push_back(std::move(chunk));
+
+        if (!spare.empty())
+        {
+            chunk = std::move(spare.back());
+            spare.pop_back();
+        }
+        else
+        {
+            chunk = std::vector<char>();
+        }
+
+        chunk.clear();
+        chunk.reserve(chunkSize);
+        changed.notify_all();
+        return true;
+    }
+
+    void finish(bool ok)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        error = !ok;
+        changed.notify_all();
+    }
+
+    void decodeGzip()
+    {
+        const uint8_t* data = (const uint8_t*)file.data;
+        size_t size = file.size;
+        size_t offset = 0;
+
+        Inflater inflater(chunkSize);
+        std::vector<char> chunk;
+        chunk.reserve(chunkSize);
+        bool alive = true;
+
+        // A gzip file may hold several members back to back; their outputs are concatenated.
+        while (alive && offset + 18 <= size)
+        {
+            const uint8_t* member = data + offset;
+            if (member[0] != 0x1f || member[1] != 0x8b || member[2] != 8) break;
+
+            uint8_t flags = member[3];
+            size_t pos = 10;
+
+            if (flags & 4) pos += 2 + (member[pos] | (member[pos + 1] << 8));
+            if (flags & 8) { while (offset + pos < size && member[pos]) ++pos; ++pos; }
+            if (flags & 16) { while (offset + pos < size && member[pos]) ++pos; ++pos; }
+            if (flags & 2) pos += 2;
+            if (offset + pos > size) break;
+
+            uint32_t crc = 0;
+            size_t memberBytes = 0;
+
+            auto sink = [&](const char* bytes, size_t n)
+            {
+                crc = crc32Update(crc, (const uint8_t*)bytes, n);
+                memberBytes += n;
+
+                while (n && alive)
+                {
+                    size_t take = std::min(n, chunkSize - chunk.size());
+                    chunk.insert(chunk.end(), bytes, bytes + take);
+                    bytes += take;
+                    n -= take;
+
+                    if (chunk.size() == chunkSize) alive = push(chunk);
+                }
+            };
+
+            if (!inflater.inflate(member + pos, size - offset - pos, sink))
+            {
+                finish(false);
+                return;
+            }
+
+            size_t trailer = offset + pos + inflater.position();
+            if (trailer + 8 > size)
+            {
+                finish(false);
+                return;
+            }
+
+            uint32_t storedCrc, storedSize;
+            std::memcpy(&storedCrc, data + trailer, 4);
+            std::memcpy(&storedSize, data + trailer + 4, 4);
+
+            if (storedCrc != crc || storedSize != (uint32_t)memberBytes)
+            {
+                finish(false);
+                return;
+            }
+
+            offset = trailer + 8;
+        }
+
+        if (alive && !chunk.empty()) alive = push(chunk);
+        finish(offset > 0);
+    }
+
+#ifdef OBJ_WITH_ZSTD
+    void decodeZstd()
+    {
+        ZSTD_DStream* stream = ZSTD_createDStream();
+        ZSTD_initDStream(stream);
+
+        ZSTD_inBuffer in = { file.data, file.size, 0 };
+        std::vector<char> chunk(chunkSize);
+        bool ok = true;
+
+        // A result of 0 means a frame ended and everything was flushed; anything else means the decoder
+        // still wants input or holds output, so it is called again even after the last input byte.
+        size_t result = 1;
+        while (in.pos < in.size || result != 0)
+        {
+            size_t consumed = in.pos;
+            chunk.resize(chunkSize);
+            ZSTD_outBuffer out = { chunk.data(), chunk.size(), 0 };
+            result = ZSTD_decompressStream(stream, &out, &in);
+
+            if (ZSTD_isError(result))
+            {
+                ok = false;
+                break;
+            }
+
+            chunk.resize(out.pos);
+            if (!chunk.empty() && !push(chunk)) break;
+
+            // No input left and nothing produced: the last frame is cut short.
+            if (in.pos == consumed && out.pos == 0)
+            {
+                ok = false;
+                break;
+            }
+        }
+
+        ZSTD_freeDStream(stream);
+        finish(ok);
+    }
+#endif
+
+public:
+    static bool isCompressed(const std::string& path)
+    {
+        return endsWith(path, ".obj.gz") || endsWith(path, ".obj.zst");
+    }
+
+    static bool isSupported(const std::string& path)
+    {
+#ifdef OBJ_WITH_ZSTD
+        return isCompressed(path);
+#else
+        return endsWith(path, ".obj.gz");
+#endif
+    }
+
+    ~CompressedObjStream()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cancelled = true;
+            changed.notify_all();
+        }
+
+        if (producer.joinable()) producer.join();
+    }
+
+    bool open(const std::string& path)
+    {
+        if (!isSupported(path) || !file.open(path))
+        {
+            return false;
+        }
+
+        // gzip stores the size of the last member mod 2^32, good enough for reserving buffers.
+        if (endsWith(path, ".gz") && file.size >= 4)
+        {
+            uint32_t size;
+            std::memcpy(&size, file.data + file.size - 4, 4);
+            expectedSize = size;
+        }
+        else
+        {
+            expectedSize = file.size * 4;
+        }
+
+#ifdef OBJ_WITH_ZSTD
+        if (endsWith(path, ".zst"))
+        {
+            producer = std::thread([this, path]()
+            {
+                TRACE_SCOPE("worker", "zstd decode", path);
+                decodeZstd();
+            });
+            return true;
+        }
+#endif
+        producer = std::thread([this, path]()
+        {
+            TRACE_SCOPE("worker", "gzip decode", path);
+            decodeGzip();
+        });
+        return true;
+    }
+
+    // Swaps the next decompressed chunk into chunk, whose old buffer is recycled. False at the end.
+    bool read(std::vector<char>& chunk)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return !filled.empty() || finished; });
+
+        if (chunk.capacity()) spare.push_back(std::move(chunk));
+
+        if (filled.empty())
+        {
+            chunk = std::vector<char>();
+            return false;
+        }
+
+        chunk = std::move(filled.front());
+        filled.pop_front();
+        changed.notify_all();
+        return true;
+    }
+
+    bool failed()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return error;
+    }
+
+    size_t compressedSize() const { return file.size; }
+    size_t sizeHint() const { return expectedSize; }
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "loader_template.h"
+#include "triangulation.h"
 
 //#ifdef _MSC_VER
 #define _CRT_SECURE_NO_WARNINGS
@@ -23,9 +24,15 @@ public:
 
     Mesh loadObjImplementation(const std::string& filename) override
     {
-        fastObjMesh* mesh = fast_obj_read(filename.c_str());
+        fastObjMesh* mesh;
+        {
+            ScopedPhaseTimer timer(LoadPhase::Parse);
+            mesh = fast_obj_read(filename.c_str());
+        }
         if (!mesh) return Mesh({}, {});
 
+        ScopedPhaseTimer timer(LoadPhase::WrapperConversion);
+
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
 
@@ -61,8 +68,28 @@ public:
                 vertices.emplace_back(pos, uv);
             else
                 vertices.emplace_back(pos);
+        }
+
+        // fast_obj keeps polygons as they are, so triangulate each face over its direct mapped vertices
+        std::vector<unsigned int> faceCorners;
+        std::vector<vec3> facePoints;
+        unsigned int firstCorner = 0;
+
+        for (unsigned int f = 0; f < mesh->face_count; ++f)
+        {
+            unsigned int count = mesh->face_vertices[f];
+
+            faceCorners.clear();
+            facePoints.clear();
+
+            for (unsigned int k = 0; k < count; ++k)
+            {
+                faceCorners.push_back(firstCorner + k);
+                facePoints.push_back(vertices[firstCorner + k].pos);
+            }
 
-            indices.push_back((unsigned int)i); // direct mapping
+            triangulateFace(faceCorners.data(), facePoints.data(), count, indices);
+            firstCorner += count;
         }
 
         fast_obj_destroy(mesh);
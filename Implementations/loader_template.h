@@ -1,5 +1,66 @@
 #pragma once
 #include "../types.h"
+#include "../Utils/memoryProfiler.h"
+#include "../Utils/perfCounters.h"
+#include "../Utils/traceEvents.h"
+
+#include <filesystem>
+
+// Phase times of the load running on this thread. Loaders that wrap another loader add to the same
+// totals, so a cache miss shows the parse it fell back to.
+static PhaseTimes& currentLoadPhases()
+{
+    static thread_local PhaseTimes phases;
+    return phases;
+}
+
+// Adds the time until the end of the scope to one phase of the current load.
+class ScopedPhaseTimer
+{
+    private:
+        LoadPhase phase;
+        std::chrono::high_resolution_clock::time_point start;
+
+    public:
+        explicit ScopedPhaseTimer(LoadPhase phase) : phase(phase), start(std::chrono::high_resolution_clock::now()) {}
+
+        ~ScopedPhaseTimer()
+        {
+            auto end = std::chrono::high_resolution_clock::now();
+            currentLoadPhases().elapsed[(size_t)phase] += end - start;
+            TRACE_COMPLETE("phase", loadPhaseName(phase), start, end);
+        }
+};
+
+// For parse loops that interleave phases line by line. The clock is only read when the phase changes,
+// and obj files keep each kind of line together, so a whole run of 'v' lines costs two clock reads.
+class PhaseSwitcher
+{
+    private:
+        LoadPhase phase = LoadPhase::Count;
+        std::chrono::high_resolution_clock::time_point start;
+
+    public:
+        void enter(LoadPhase next)
+        {
+            if (next == phase) return;
+
+            auto now = std::chrono::high_resolution_clock::now();
+            if (phase != LoadPhase::Count)
+            {
+                currentLoadPhases().elapsed[(size_t)phase] += now - start;
+                TRACE_COMPLETE("phase", loadPhaseName(phase), start, now);
+            }
+
+            phase = next;
+            start = now;
+        }
+
+        ~PhaseSwitcher()
+        {
+            enter(LoadPhase::Count);
+        }
+};
 
 class LoaderTemplate
 {
@@ -12,8 +73,10 @@ class LoaderTemplate
         {
             auto start = std::chrono::high_resolution_clock::now();
             std::cout << "Loading: " << filename << " ";
+            TRACE_SCOPE("load", Name(), filename);
 
-            Mesh mesh = this->loadObjImplementation(filename);
+            Mesh mesh = this->loadObjImplementation(InputPath(filename));
+            if (compactIndexBuffers) mesh.packIndices();
 
             auto end = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
@@ -28,20 +91,60 @@ class LoaderTemplate
             std::vector<Result> results;
             results.reserve(paths.size());
 
+            PerfCounterSession counters(collectPerfCounters);
+            MemoryProbe memory;
+
             for (const std::string& path : paths)
             {
+                currentLoadPhases() = PhaseTimes();
+                TRACE_SCOPE("load", Name(), path);
+
+                std::error_code error;
+                uintmax_t inputBytes = std::filesystem::file_size(InputPath(path), error);
+
+                memory.start();
                 auto start = std::chrono::high_resolution_clock::now();
-                Mesh mesh = this->loadObjImplementation(path);
+                counters.start();
+                Mesh mesh = this->loadObjImplementation(InputPath(path));
+                PerfCounterValues counted = counters.stop();
+                if (compactIndexBuffers)
+                {
+                    ScopedPhaseTimer timer(LoadPhase::Assembly);
+                    mesh.packIndices();
+                }
                 auto end = std::chrono::high_resolution_clock::now();
+                MemoryUsage used = memory.stop();
                 auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 
                 std::cout << "Loaded " << path << " in " << duration.count() << " ms.\n";
 
-                results.push_back({ mesh, duration });
+                results.push_back({ mesh, duration, {}, currentLoadPhases(), counted, error ? 0 : (size_t)inputBytes, used, path });
             }
 
             return results;
         }
 
         virtual Mesh loadObjImplementation(const std::string& filename) = 0;
-};
\ No newline at end of file
+
+        // File actually read for one of the scanned objs; loaders of other formats point this at a
+        // converted copy of the same geometry.
+        virtual std::string InputPath(const std::string& objPath) const
+        {
+            return objPath;
+        }
+
+        // Extra per-loader values for the summary, gathered after loadAllObjs.
+        virtual MetricList Metrics() const
+        {
+            return {};
+        }
+};
+
+// Converted copy of an obj for loaders of other formats, e.g. Objs\cube.obj -> Interchange\Objs_cube.ply.
+static std::string interchangePath(const std::string& objPath, const char* extension)
+{
+    std::string name = flattenedFileName(objPath);
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".obj") == 0) name.resize(name.size() - 4);
+
+    return std::string(interchangeFolderPath) + pathSeparator + name + extension;
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "loader_template.h"
+#include "cached_loader.h"
+
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+
+// In-process cache of parsed meshes keyed by path and loader options. Meshes are handed out as
+// shared immutable handles, so evicting an entry never invalidates a mesh somebody is still using.
+// Concurrent requests for a file that is being loaded wait on the same load instead of parsing again.
+class MeshMemoryCache
+{
+private:
+    struct Entry
+    {
+        std::shared_future<std::shared_ptr<const Mesh>> mesh;
+        std::list<std::string>::iterator lruPosition;
+        size_t bytes = 0;
+        bool ready = false;
+    };
+
+    LoaderTemplate* loader;
+    size_t maxBytes;
+    bool serializeLoads;
+    uint64_t optionsHash;
+
+    std::mutex mutex;
+    std::mutex loadMutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> lru; // most recently used first
+    size_t residentBytes = 0;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t coalesced = 0;
+    size_t evictions = 0;
+
+    static size_t meshBytes(const Mesh& mesh)
+    {
+        return mesh.vertices.size() * sizeof(Vertex)
+            + mesh.indexBytes()
+            + mesh.smoothingGroups.size() * sizeof(unsigned int);
+    }
+
+    // Called with mutex held. Only finished entries are evicted, pending loads stay until they complete.
+    void evict()
+    {
+        auto it = lru.end();
+
+        while (residentBytes > maxBytes && it != lru.begin())
+        {
+            --it;
+            auto entry = entries.find(*it);
+            if (entry == entries.end() || !entry->second.ready) continue;
+
+            residentBytes -= entry->second.bytes;
+            entries.erase(entry);
+            it = lru.erase(it);
+            evictions++;
+        }
+    }
+
+public:
+    // serializeLoads guards loaders that are not reentrant, such as NewFast with its reused parse buffers.
+    MeshMemoryCache(LoaderTemplate* loader, size_t maxBytes = 512ull << 20, bool serializeLoads = true)
+        : loader(loader), maxBytes(maxBytes), serializeLoads(serializeLoads), optionsHash(loaderOptionsHash(*loader))
+    {}
+
+    std::shared_ptr<const Mesh> get(const std::string& path)
+    {
+        std::string key = path + "|" + std::to_string(optionsHash);
+        std::promise<std::shared_ptr<const Mesh>> promise;
+        std::shared_future<std::shared_ptr<const Mesh>> existing;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto it = entries.find(key);
+            if (it != entries.end())
+            {
+                if (it->second.ready)
+                {
+                    hits++;
+                    lru.splice(lru.begin(), lru, it->second.lruPosition);
+                }
+                else
+                {
+                    coalesced++;
+                }
+
+                existing = it->second.mesh;
+            }
+            else
+            {
+                misses++;
+                Entry& entry = entries[key];
+                entry.mesh = promise.get_future().share();
+                entry.lruPosition = lru.insert(lru.begin(), key);
+            }
+        }
+
+        // Wait outside the lock, the thread doing the load needs it to publish the result.
+        if (existing.valid())
+        {
+            return existing.get();
+        }
+
+        std::shared_ptr<const Mesh> mesh;
+
+        try
+        {
+            Mesh loaded;
+
+            if (serializeLoads)
+            {
+                std::lock_guard<std::mutex> lock(loadMutex);
+                loaded = loader->loadObjImplementation(path);
+            }
+            else
+            {
+                loaded = loader->loadObjImplementation(path);
+            }
+
+            if (compactIndexBuffers) loaded.packIndices();
+            mesh = std::make_shared<const Mesh>(std::move(loaded));
+        }
+        catch (...)
+        {
+            // A failed load must not leave a pending entry behind: the next request loads again,
+            // and everybody already waiting on this one gets the same exception.
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                auto it = entries.find(key);
+                if (it != entries.end())
+                {
+                    lru.erase(it->second.lruPosition);
+                    entries.erase(it);
+                }
+            }
+
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            Entry& entry = entries[key];
+            entry.bytes = meshBytes(*mesh);
+            entry.ready = true;
+            residentBytes += entry.bytes;
+
+            evict();
+        }
+
+        promise.set_value(mesh);
+        return mesh;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->second.ready)
+            {
+                lru.erase(it->second.lruPosition);
+                it = entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        residentBytes = 0;
+    }
+
+    MetricList Metrics()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return {
+            { "Hits", (double)hits },
+            { "Misses", (double)misses },
+            { "Coalesced waits", (double)coalesced },
+            { "Evictions", (double)evictions },
+            { "Resident MB", residentBytes / (1024.0 * 1024.0) }
+        };
+    }
+};
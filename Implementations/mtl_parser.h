@@ -0,0 +1,263 @@
+#pragma once
+
+#include "../types.h"
+#include "../Externals/fast_float.h"
+
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string_view>
+
+// One 'newmtl' block. Names and texture paths are ids into the owning library's string table, with 0
+// meaning not set, so materials that share a texture share its string.
+struct Material
+{
+    uint32_t name = 0;
+    vec3 ambient = vec3(0.0f);
+    vec3 diffuse = vec3(1.0f);
+    vec3 specular = vec3(0.0f);
+    vec3 emission = vec3(0.0f);
+    float shininess = 1.0f;
+    float dissolve = 1.0f;
+    float ior = 1.0f;
+    int illum = 0;
+    uint32_t ambientMap = 0;
+    uint32_t diffuseMap = 0;
+    uint32_t specularMap = 0;
+    uint32_t emissionMap = 0;
+    uint32_t bumpMap = 0;
+    uint32_t alphaMap = 0;
+};
+
+// Materials of one or more MTL files with every name and path stored once. Strings live in a deque
+// so the views used as lookup keys stay valid while the table grows.
+class MaterialLibrary
+{
+private:
+    std::deque<std::string> strings{ std::string() };
+    std::unordered_map<std::string_view, uint32_t> stringIds;
+    std::unordered_map<uint32_t, uint32_t> materialIds;
+
+public:
+    std::vector<Material> materials;
+
+    // The 'mtllib' names the materials were read from, relative to the obj's folder.
+    std::vector<std::string> sources;
+
+    MaterialLibrary() = default;
+
+    // A copy would take views into the other library's strings; moving a deque keeps its elements in place.
+    MaterialLibrary(const MaterialLibrary&) = delete;
+    MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+    MaterialLibrary(MaterialLibrary&&) = default;
+    MaterialLibrary& operator=(MaterialLibrary&&) = default;
+
+    uint32_t intern(std::string_view text)
+    {
+        if (text.empty()) return 0;
+
+        auto found = stringIds.find(text);
+        if (found != stringIds.end()) return found->second;
+
+        uint32_t id = (uint32_t)strings.size();
+        strings.emplace_back(text);
+        stringIds.emplace(strings.back(), id);
+        return id;
+    }
+
+    const std::string& string(uint32_t id) const
+    {
+        return strings[id];
+    }
+
+    size_t stringCount() const
+    {
+        return strings.size() - 1;
+    }
+
+    // Starts a material, or restarts it when the name was defined before so the last definition wins.
+    Material& define(std::string_view name)
+    {
+        uint32_t id = intern(name);
+        auto found = materialIds.find(id);
+        if (found != materialIds.end())
+        {
+            materials[found->second] = Material();
+            materials[found->second].name = id;
+            return materials[found->second];
+        }
+
+        materialIds.emplace(id, (uint32_t)materials.size());
+        materials.emplace_back();
+        materials.back().name = id;
+        return materials.back();
+    }
+
+    // Index into materials, -1 when no material has that name.
+    int find(std::string_view name) const
+    {
+        auto id = stringIds.find(name);
+        if (id == stringIds.end()) return -1;
+
+        auto found = materialIds.find(id->second);
+        return found == materialIds.end() ? -1 : (int)found->second;
+    }
+
+    // Adds the materials of another library, interning its strings into this one.
+    void merge(const MaterialLibrary& other)
+    {
+        sources.insert(sources.end(), other.sources.begin(), other.sources.end());
+
+        for (const Material& source : other.materials)
+        {
+            Material& target = define(other.string(source.name));
+            uint32_t name = target.name;
+            target = source;
+            target.name = name;
+            target.ambientMap = intern(other.string(source.ambientMap));
+            target.diffuseMap = intern(other.string(source.diffuseMap));
+            target.specularMap = intern(other.string(source.specularMap));
+            target.emissionMap = intern(other.string(source.emissionMap));
+            target.bumpMap = intern(other.string(source.bumpMap));
+            target.alphaMap = intern(other.string(source.alphaMap));
+        }
+    }
+};
+
+#pragma region Helper functions
+static inline const char* skipMtlSpaces(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+static inline void parseMtlFloat(const char* p, const char* end, float& value)
+{
+    p = skipMtlSpaces(p, end);
+    fast_float::from_chars(p, end, value);
+}
+
+// "r g b", or a single value for grey. Spectral and xyz colors leave the default alone.
+static inline void parseMtlColor(const char* p, const char* end, vec3& color)
+{
+    float values[3];
+    int count = 0;
+
+    while (count < 3)
+    {
+        p = skipMtlSpaces(p, end);
+        auto result = fast_float::from_chars(p, end, values[count]);
+        if (result.ec != std::errc()) break;
+
+        p = result.ptr;
+        ++count;
+    }
+
+    if (count == 3) color = vec3(values[0], values[1], values[2]);
+    else if (count > 0) color = vec3(values[0]);
+}
+
+// Texture statements may carry options such as "-bm 0.5" before the path; the path is the last token.
+static inline std::string_view mtlTexturePath(const char* p, const char* end)
+{
+    const char* start = skipMtlSpaces(p, end);
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) --end;
+
+    const char* last = end;
+    while (last > start && last[-1] != ' ' && last[-1] != '\t') --last;
+
+    return std::string_view(last, end - last);
+}
+
+static inline bool mtlKeyword(const char* line, const char* lineEnd, const char* keyword, size_t length, const char*& rest)
+{
+    if ((size_t)(lineEnd - line) <= length || std::memcmp(line, keyword, length) != 0) return false;
+    if (line[length] != ' ' && line[length] != '\t') return false;
+
+    rest = line + length;
+    return true;
+}
+#pragma endregion
+
+// Parses MTL text in place: statements are matched on the mapped bytes and only names and paths are
+// copied, once each, into the library's string table.
+static void parseMtl(const char* data, const char* end, MaterialLibrary& library)
+{
+    Material scratch; // statements before the first 'newmtl' have nowhere to go
+    Material* current = &scratch;
+
+    while (data < end)
+    {
+        const char* lineStart = skipMtlSpaces(data, end);
+        while (data < end && *data != '\n') data++;
+        const char* lineEnd = data;
+
+        if (data < end) data++; // skip newline
+        if (lineEnd == lineStart || *lineStart == '#') continue;
+
+        const char* rest;
+        char c0 = lineStart[0];
+        char c1 = lineEnd - lineStart > 1 ? lineStart[1] : 0;
+
+        if (c0 == 'K' && lineEnd - lineStart > 2 && (lineStart[2] == ' ' || lineStart[2] == '\t'))
+        {
+            vec3* color = c1 == 'd' ? &current->diffuse : c1 == 'a' ? &current->ambient : c1 == 's' ? &current->specular : c1 == 'e' ? &current->emission : nullptr;
+            if (color) parseMtlColor(lineStart + 2, lineEnd, *color);
+        }
+        else if (mtlKeyword(lineStart, lineEnd, "newmtl", 6, rest))
+        {
+            const char* nameEnd = lineEnd;
+            while (nameEnd > rest && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r')) --nameEnd;
+            rest = skipMtlSpaces(rest, nameEnd);
+
+            current = &library.define(std::string_view(rest, nameEnd - rest));
+        }
+        else if (mtlKeyword(lineStart, lineEnd, "Ns", 2, rest)) parseMtlFloat(rest, lineEnd, current->shininess);
+        else if (mtlKeyword(lineStart, lineEnd, "Ni", 2, rest)) parseMtlFloat(rest, lineEnd, current->ior);
+        else if (mtlKeyword(lineStart, lineEnd, "d", 1, rest)) parseMtlFloat(rest, lineEnd, current->dissolve);
+        else if (mtlKeyword(lineStart, lineEnd, "Tr", 2, rest))
+        {
+            float transparency = 0.0f;
+            parseMtlFloat(rest, lineEnd, transparency);
+            current->dissolve = 1.0f - transparency;
+        }
+        else if (mtlKeyword(lineStart, lineEnd, "illum", 5, rest))
+        {
+            float illum = 0.0f;
+            parseMtlFloat(rest, lineEnd, illum);
+            current->illum = (int)illum;
+        }
+        else if (mtlKeyword(lineStart, lineEnd, "map_Kd", 6, rest)) current->diffuseMap = library.intern(mtlTexturePath(rest, lineEnd));
+        else if (mtlKeyword(lineStart, lineEnd, "map_Ka", 6, rest)) current->ambientMap = library.intern(mtlTexturePath(rest, lineEnd));
+        else if (mtlKeyword(lineStart, lineEnd, "map_Ks", 6, rest)) current->specularMap = library.intern(mtlTexturePath(rest, lineEnd));
+        else if (mtlKeyword(lineStart, lineEnd, "map_Ke", 6, rest)) current->emissionMap = library.intern(mtlTexturePath(rest, lineEnd));
+        else if (mtlKeyword(lineStart, lineEnd, "map_d", 5, rest)) current->alphaMap = library.intern(mtlTexturePath(rest, lineEnd));
+        else if (mtlKeyword(lineStart, lineEnd, "map_Bump", 8, rest) || mtlKeyword(lineStart, lineEnd, "map_bump", 8, rest)
+            || mtlKeyword(lineStart, lineEnd, "bump", 4, rest) || mtlKeyword(lineStart, lineEnd, "norm", 4, rest))
+        {
+            current->bumpMap = library.intern(mtlTexturePath(rest, lineEnd));
+        }
+    }
+}
+
+// Parses every library an 'mtllib' statement names; paths are relative to the obj's folder. Missing
+// files are skipped, an obj renders fine with default materials.
+static std::shared_ptr<MaterialLibrary> loadMaterialLibraries(const std::string& objFilename, const std::vector<std::string>& names)
+{
+    size_t slash = objFilename.find_last_of("\\/");
+    std::string folder = slash == std::string::npos ? "" : objFilename.substr(0, slash + 1);
+
+    auto library = std::make_shared<MaterialLibrary>();
+    library->sources = names;
+
+    for (const std::string& name : names)
+    {
+        MappedFile file;
+        if (file.open(folder + name) && file.size > 0)
+        {
+            parseMtl(file.data, file.data + file.size, *library);
+        }
+    }
+
+    return library;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "loader_template.h"
+#include "triangulation.h"
+#include "submeshes.h"
 
 #pragma region Helper functions
 float _stringToFloat(const std::string& source) {
@@ -56,6 +58,9 @@ class Naive : public  LoaderTemplate
             std::vector<Vertex> vertices;
             std::vector<unsigned int> indices;
 
+            PhaseSwitcher phases;
+            phases.enter(LoadPhase::OpenMap);
+
             std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
             if (!file.good())
             {
@@ -65,6 +70,9 @@ class Naive : public  LoaderTemplate
 
             std::string line;
             std::vector<std::string> tokens, facetokens;
+            std::vector<unsigned int> faceCorners;
+            std::vector<vec3> facePoints;
+            SubmeshBuilder submeshBuilder;
 
             std::vector<vec3> positions;
             positions.reserve(1000);
@@ -75,8 +83,13 @@ class Naive : public  LoaderTemplate
             std::vector<vec2> texcoords;
             texcoords.reserve(1000);
 
-            while (std::getline(file, line))
+            while (true)
             {
+                // Reading and tokenizing the line is the scan, converting the tokens the parse.
+                phases.enter(LoadPhase::Scan);
+                if (!std::getline(file, line))
+                    break;
+
                 _stringTokenize(line, tokens);
 
                 if (tokens.size() == 0)
@@ -85,6 +98,8 @@ class Naive : public  LoaderTemplate
                 if (tokens[0].at(0) == '#')
                     continue;
 
+                phases.enter(tokens[0] == "f" ? LoadPhase::FaceParse : LoadPhase::AttributeParse);
+
                 if (tokens.size() > 3 && tokens[0] == "v")
                     positions.push_back(vec3(_stringToFloat(tokens[1]), _stringToFloat(tokens[2]), _stringToFloat(tokens[3])));
 
@@ -94,6 +109,15 @@ class Naive : public  LoaderTemplate
                 if (tokens.size() > 2 && tokens[0] == "vt")
                     texcoords.push_back(vec2(_stringToFloat(tokens[1]), _stringToFloat(tokens[2])));
 
+                if (tokens[0] == "o" || tokens[0] == "g" || tokens[0] == "usemtl")
+                {
+                    std::string name = line.substr(line.find(tokens[0]) + tokens[0].size());
+
+                    if (tokens[0] == "o") submeshBuilder.setObject(name.data(), name.data() + name.size(), indices.size());
+                    else if (tokens[0] == "g") submeshBuilder.setGroup(name.data(), name.data() + name.size(), indices.size());
+                    else submeshBuilder.setMaterial(name.data(), name.data() + name.size(), indices.size());
+                }
+
                 if (tokens.size() >= 4 && tokens[0] == "f")
                 {
                     unsigned int face_format = 0;
@@ -114,7 +138,8 @@ class Naive : public  LoaderTemplate
                         }
                     }
 
-                    unsigned int index_of_first_vertex_of_face = std::numeric_limits<unsigned int>::max();
+                    faceCorners.clear();
+                    facePoints.clear();
 
                     for (unsigned int num_token = 1; num_token < tokens.size(); num_token++)
                     {
@@ -170,24 +195,18 @@ class Naive : public  LoaderTemplate
                             vertices.push_back(Vertex(positions[p_index].x, positions[p_index].y, positions[p_index].z, normals[n_index].x, normals[n_index].y, normals[n_index].z, texcoords[t_index].x, texcoords[t_index].y));
                         }
 
-                        if (num_token < 4)
-                        {
-                            if (num_token == 1)
-                                index_of_first_vertex_of_face = vertices.size() - 1;
-
-                            indices.push_back(vertices.size() - 1);
-                        }
-                        else
-                        {
-                            indices.push_back(index_of_first_vertex_of_face);
-                            indices.push_back(vertices.size() - 2);
-                            indices.push_back(vertices.size() - 1);
-                        }
+                        faceCorners.push_back(vertices.size() - 1);
+                        facePoints.push_back(vertices.back().pos);
                     }
+
+                    triangulateFace(faceCorners.data(), facePoints.data(), faceCorners.size(), indices);
                 }
             }
 
+            phases.enter(LoadPhase::Assembly);
+
             Mesh mesh(vertices, indices);
+            submeshBuilder.finish(mesh.indices(), mesh.smoothingGroups, mesh.submeshes);
             return mesh;
         }
 };
\ No newline at end of file
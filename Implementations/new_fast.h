@@ -1,8 +1,15 @@
 #pragma once
 
 #include "loader_template.h"
+#include "triangulation.h"
+#include "compressed_stream.h"
+#include "submeshes.h"
+#include "mtl_parser.h"
+#include "parse_kernels.h"
 #include "../Externals/fast_float.h"
 
+#include <future>
+
 #pragma region Helper functions
 static inline int parseInt(const char* s, size_t n)
 {
@@ -21,38 +28,6 @@ static inline int parseInt(const char* s, size_t n)
     return value * sign;
 }
 
-static inline float parseFloat(const char* s, size_t n)
-{
-    int sign = 1;
-    if (*s == '-')
-    {
-        sign = -1; ++s; --n;
-    }
-
-    float value = 0.0f;
-    while (n && *s >= '0' && *s <= '9')
-    {
-        value = value * 10.0f + (*s - '0');
-        ++s; --n;
-    }
-
-    if (n && *s == '.')
-    {
-        ++s; --n;
-        float frac = 0.0f;
-        float base = 0.1f;
-        while (n && *s >= '0' && *s <= '9')
-        {
-            frac += (*s - '0') * base;
-            base *= 0.1f;
-            ++s; --n;
-        }
-        value += frac;
-    }
-
-    return value * sign;
-}
-
 static inline int resolveIndex(int idx, int size)
 {
     if (idx == 0) return -1; // invalid OBJ index
@@ -74,16 +49,19 @@ struct VertexKey {
     }
 };
 
+// An entry is in use when its generation matches the cache's, so reset empties the table between
+// loads without touching it.
 struct FastVertexCache {
     struct Entry {
         VertexKey key;
         int index;
-        bool used = false;
+        unsigned int generation = 0;
     };
 
     std::vector<Entry> table;
     size_t capacity;
     size_t count;
+    unsigned int generation = 1;
 
     FastVertexCache(size_t cap = 1 << 20) {
         capacity = 1;
@@ -92,6 +70,20 @@ struct FastVertexCache {
         count = 0;
     }
 
+    // Empties the cache, keeping the table when it already holds at least cap entries.
+    void reset(size_t cap) {
+        if (capacity < cap) {
+            *this = FastVertexCache(cap);
+            return;
+        }
+
+        count = 0;
+        if (++generation == 0) {
+            for (auto& e : table) e.generation = 0;
+            generation = 1;
+        }
+    }
+
     inline size_t hash(const VertexKey& k) const {
         return ((size_t)k.p * 73856093u) ^
             ((size_t)k.t * 19349663u) ^
@@ -103,11 +95,11 @@ struct FastVertexCache {
         std::vector<Entry> newTable(newCapacity);
 
         for (auto& e : table) {
-            if (!e.used) continue;
+            if (e.generation != generation) continue;
 
             size_t idx = hash(e.key) & (newCapacity - 1);
 
-            while (newTable[idx].used) {
+            while (newTable[idx].generation == generation) {
                 idx = (idx + 1) & (newCapacity - 1);
             }
 
@@ -127,8 +119,8 @@ struct FastVertexCache {
         size_t idx = hash(key) & (capacity - 1);
 
         while (true) {
-            if (!table[idx].used) {
-                table[idx].used = true;
+            if (table[idx].generation != generation) {
+                table[idx].generation = generation;
                 table[idx].key = key;
                 table[idx].index = newIndex;
                 count++;
@@ -152,6 +144,34 @@ struct FastVertexCache {
 class NewFast : public  LoaderTemplate
 {
 private:
+    // Parser state, kept between loads so the buffers keep their capacity. Not reentrant.
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> smoothingGroups;
+    std::vector<vec3> positions;
+    std::vector<vec3> normals;
+    std::vector<vec2> texcoords;
+    std::vector<unsigned int> faceCorners;
+    std::vector<vec3> facePoints;
+    FastVertexCache cache{ 1 };
+    SubmeshBuilder submeshBuilder;
+
+    // Each 'mtllib' statement is parsed on its own thread while the geometry parse carries on.
+    std::vector<std::future<std::shared_ptr<MaterialLibrary>>> materialLoads;
+    std::string filename;
+
+    // Off gives the flat mode: 'o', 'g' and 'usemtl' are skipped like before submeshes existed.
+    bool buildSubmeshes;
+    TriangulationMode triangulation;
+    std::string name;
+
+    // Newline scan, float and index parsing, picked for the CPU when the loader is created.
+    ParseKernels kernels;
+
+    // Groups are only recorded once the file uses them, faces before the first 's' are "off".
+    bool hasSmoothingGroups = false;
+    unsigned int smoothingGroup = 0;
+
     static void addVertex(std::vector<Vertex>& vertices,
         const std::vector<vec3>& positions,
         const std::vector<vec3>& normals,
@@ -175,138 +195,108 @@ private:
             vertices.emplace_back(positions[pIdx]);
         }
     }
-public:
-    const char* Name() const override
-    {
-        static std::string nameDedup = "new fast with vertex dedup";
-        static std::string nameRaw = "new fast";
-
-        return deduplicateVertices ? nameDedup.c_str() : nameRaw.c_str();
-    }
 
-    Mesh loadObjImplementation(const std::string& filename) override
+    void beginParse(const std::string& filename, size_t size)
     {
-        MappedFile file;
-        if (!file.open(filename)) {
-            std::cout << "Failed to open file\n";
-            std::terminate();
-        }
+        {
+            ScopedPhaseTimer timer(LoadPhase::Assembly);
 
-        const char* data = file.data;
-        const char* end = data + file.size;
+            this->filename = filename;
+            materialLoads.clear();
 
-        size_t size = file.size;
+            vertices.clear();
+            indices.clear();
+            smoothingGroups.clear();
+            positions.clear();
+            normals.clear();
+            texcoords.clear();
 
-        static std::vector<Vertex> vertices;
-        static std::vector<unsigned int> indices;
-        static std::vector<vec3> positions;
-        static std::vector<vec3> normals;
-        static std::vector<vec2> texcoords;
+            positions.reserve(size / 20);
+            normals.reserve(size / 40);
+            texcoords.reserve(size / 40);
+            vertices.reserve(size / 10);
+            indices.reserve(size / 5);
 
-        vertices.clear();
-        indices.clear();
-        positions.clear();
-        normals.clear();
-        texcoords.clear();
+            hasSmoothingGroups = false;
+            smoothingGroup = 0;
 
-        positions.reserve(size / 20);
-        normals.reserve(size / 40);
-        texcoords.reserve(size / 40);
-        vertices.reserve(size / 10);
-        indices.reserve(size / 5);
+            submeshBuilder.reset();
+        }
 
-        FastVertexCache cache(1 << 20);
+        // The table is only needed with dedup on, and is kept between loads.
+        if (deduplicateVertices)
+        {
+            ScopedPhaseTimer timer(LoadPhase::Dedup);
+            cache.reset(1 << 20);
+        }
+    }
+
+    // Parses whole lines in [data, end); the last line must end in '\n' or at the end of the file.
+    // Dedup happens inline per corner and is counted as face parse.
+    void parseLines(const char* data, const char* end)
+    {
+        PhaseSwitcher phases;
 
         while (data < end)
         {
             const char* lineStart = data;
-            while (data < end && *data != '\n') data++;
+            data = kernels.findNewline(data, end);
             const char* lineEnd = data;
 
             if (data < end) data++; // skip newline
             if (lineEnd == lineStart) continue;
             if (*lineStart == '#') continue;
 
+            phases.enter(lineStart[0] == 'f' ? LoadPhase::FaceParse : LoadPhase::AttributeParse);
+
             // Parse vertices, normals, texcoords
             if (lineStart[0] == 'v' && (lineStart[1] == ' ' || lineStart[1] == '\t'))
             {
-                const char* p = lineStart + 1;
-                while (*p == ' ' || *p == '\t') ++p;
-                const char* a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                float x = parseFloat(a, p - a);
-                //fast_float::from_chars(a, p, x);
-                while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
-                a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                float y = parseFloat(a, p - a);
-                //fast_float::from_chars(a, p, y);
-                while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
-                a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                float z = parseFloat(a, p - a);
-                //fast_float::from_chars(a, p, z);
-                positions.emplace_back(x, y, z);
+                float xyz[3] = {};
+                kernels.parseFloats(lineStart + 1, lineEnd, end, xyz, 3);
+                positions.emplace_back(xyz[0], xyz[1], xyz[2]);
             }
             else if (lineStart[0] == 'v' && lineStart[1] == 'n')
             {
-                const char* p = lineStart + 2;
-                while (*p == ' ' || *p == '\t') ++p;
-                const char* a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                float x = parseFloat(a, p - a);
-                //fast_float::from_chars(a, p, x);
-                while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
-                a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                float y = parseFloat(a, p - a);
-                //fast_float::from_chars(a, p, y);
-                while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
-                a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                float z;// = parseFloat(a, p - a);
-                //fast_float::from_chars(a, p, z);
-                normals.emplace_back(x, y, z);
+                float xyz[3] = {};
+                kernels.parseFloats(lineStart + 2, lineEnd, end, xyz, 3);
+                normals.emplace_back(xyz[0], xyz[1], xyz[2]);
             }
             else if (lineStart[0] == 'v' && lineStart[1] == 't')
             {
-                const char* p = lineStart + 2;
-                while (*p == ' ' || *p == '\t') ++p;
-                const char* a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                float u = parseFloat(a, p - a);
-                //fast_float::from_chars(a, p, u);
+                float uv[2] = {};
+                kernels.parseFloats(lineStart + 2, lineEnd, end, uv, 2);
+                texcoords.emplace_back(uv[0], uv[1]);
+            }
+            else if (lineStart[0] == 's' && (lineStart[1] == ' ' || lineStart[1] == '\t'))
+            {
+                const char* p = lineStart + 1;
                 while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
-                a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                float v = parseFloat(a, p - a);
-                //fast_float::from_chars(a, p, v);
-                texcoords.emplace_back(u, v);
+                const char* a = p; while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+
+                smoothingGroup = (p - a == 3 && a[0] == 'o' && a[1] == 'f' && a[2] == 'f') ? 0 : (unsigned int)parseInt(a, p - a);
+
+                if (!hasSmoothingGroups)
+                {
+                    smoothingGroups.assign(indices.size() / 3, 0);
+                    hasSmoothingGroups = true;
+                }
             }
             else if (lineStart[0] == 'f')
             {
                 const char* p = lineStart + 1;
-                while (*p == ' ' || *p == '\t') ++p;
 
-                int firstIndex = -1, prevIndex = -1;
+                faceCorners.clear();
+                facePoints.clear();
 
                 while (p < lineEnd)
                 {
-                    int pIdx = 0, tIdx = 0, nIdx = 0;
-                    const char* a = p; while (p < lineEnd && *p != '/' && *p != ' ' && *p != '\t') ++p;
-                    pIdx = parseInt(a, p - a);
+                    // Separators are skipped first, so a corner dropped below still moves p forward.
+                    while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
+                    if (p == lineEnd) break;
 
-                    if (p < lineEnd && *p == '/')
-                    {
-                        ++p;
-                        if (*p == '/')
-                        {
-                            ++p; a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                            nIdx = parseInt(a, p - a);
-                        }
-                        else
-                        {
-                            a = p; while (p < lineEnd && *p != '/' && *p != ' ' && *p != '\t') ++p;
-                            tIdx = parseInt(a, p - a);
-                            if (p < lineEnd && *p == '/')
-                            {
-                                ++p; a = p; while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
-                                nIdx = parseInt(a, p - a);
-                            }
-                        }
-                    }
+                    int pIdx, tIdx, nIdx;
+                    p = kernels.parseCorner(p, lineEnd, end, &pIdx, &tIdx, &nIdx);
 
                     pIdx = resolveIndex(pIdx, (int)positions.size());
                     tIdx = (tIdx != 0) ? resolveIndex(tIdx, (int)texcoords.size()) : -1;
@@ -333,21 +323,163 @@ public:
                         addVertex(vertices, positions, normals, texcoords, pIdx, nIdx, tIdx);
                     }
 
-                    if (firstIndex < 0) firstIndex = finalIndex;
-                    else if (prevIndex >= 0)
-                    {
-                        indices.push_back(firstIndex);
-                        indices.push_back(prevIndex);
-                        indices.push_back(finalIndex);
-                    }
+                    faceCorners.push_back(finalIndex);
+                    facePoints.push_back(positions[pIdx]);
+                }
 
-                    prevIndex = finalIndex;
+                size_t triangleCount = triangulateFace(faceCorners.data(), facePoints.data(), faceCorners.size(), indices, triangulation);
 
-                    while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
+                if (hasSmoothingGroups) smoothingGroups.insert(smoothingGroups.end(), triangleCount, smoothingGroup);
+            }
+            else if (buildSubmeshes && (lineStart[0] == 'o' || lineStart[0] == 'g') && (lineEnd - lineStart == 1 || lineStart[1] == ' ' || lineStart[1] == '\t' || lineStart[1] == '\r'))
+            {
+                if (lineStart[0] == 'o') submeshBuilder.setObject(lineStart + 1, lineEnd, indices.size());
+                else submeshBuilder.setGroup(lineStart + 1, lineEnd, indices.size());
+            }
+            else if (buildSubmeshes && lineEnd - lineStart > 6 && std::memcmp(lineStart, "usemtl", 6) == 0)
+            {
+                submeshBuilder.setMaterial(lineStart + 6, lineEnd, indices.size());
+            }
+            else if (buildSubmeshes && lineEnd - lineStart > 6 && std::memcmp(lineStart, "mtllib", 6) == 0)
+            {
+                std::vector<std::string> names;
+                const char* p = lineStart + 6;
+                while (p < lineEnd)
+                {
+                    while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+                    const char* a = p; while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+                    if (p > a) names.emplace_back(a, p);
+                }
+
+                materialLoads.push_back(std::async(std::launch::async, loadMaterialLibraries, filename, names));
+            }
+        }
+    }
+
+    Mesh finishParse()
+    {
+        ScopedPhaseTimer timer(LoadPhase::Assembly);
+
+        Mesh mesh(vertices, indices, smoothingGroups);
+        if (buildSubmeshes) submeshBuilder.finish(mesh.indices(), mesh.smoothingGroups, mesh.submeshes);
+
+        std::shared_ptr<MaterialLibrary> materials;
+        for (auto& load : materialLoads)
+        {
+            std::shared_ptr<MaterialLibrary> library = load.get();
+            if (!materials) materials = library;
+            else materials->merge(*library);
+        }
+
+        materialLoads.clear();
+        mesh.materials = materials;
+
+        return mesh;
+    }
+
+    // Chunks arrive from the decompression thread; a line split across two chunks is carried over.
+    Mesh loadCompressed(const std::string& filename)
+    {
+        CompressedObjStream stream;
+        {
+            ScopedPhaseTimer timer(LoadPhase::OpenMap);
+            if (!stream.open(filename)) {
+                std::cout << "Failed to open file\n";
+                std::terminate();
+            }
+        }
+
+        beginParse(filename, stream.sizeHint());
+
+        std::vector<char> chunk;
+        std::vector<char> carry;
+
+        // Time spent waiting for the next decompressed chunk counts as opening the input.
+        auto readChunk = [&]()
+        {
+            ScopedPhaseTimer timer(LoadPhase::OpenMap);
+            return stream.read(chunk);
+        };
+
+        while (readChunk())
+        {
+            const char* data = chunk.data();
+            const char* end = data + chunk.size();
+
+            if (!carry.empty())
+            {
+                const char* newline = (const char*)std::memchr(data, '\n', end - data);
+                if (!newline)
+                {
+                    carry.insert(carry.end(), data, end);
+                    continue;
                 }
+
+                carry.insert(carry.end(), data, newline + 1);
+                parseLines(carry.data(), carry.data() + carry.size());
+                carry.clear();
+                data = newline + 1;
             }
+
+            const char* last = end;
+            while (last > data && last[-1] != '\n') --last;
+
+            parseLines(data, last);
+            carry.insert(carry.end(), last, end);
         }
 
-        return Mesh(vertices, indices);
+        if (stream.failed())
+        {
+            std::cout << "Failed to decompress " << filename << "\n";
+        }
+
+        if (!carry.empty())
+        {
+            carry.push_back('\n');
+            parseLines(carry.data(), carry.data() + carry.size());
+        }
+
+        return finishParse();
+    }
+public:
+    NewFast(bool buildSubmeshes = true, KernelIsa isa = kernelIsa, TriangulationMode triangulation = triangulationMode)
+        : buildSubmeshes(buildSubmeshes), triangulation(triangulation), kernels(selectParseKernels(isa))
+    {
+        name = deduplicateVertices ? "new fast with vertex dedup" : "new fast";
+        if (triangulation != TriangulationMode::Auto) name += std::string(" (") + triangulationModeName(triangulation) + ")";
+        if (!buildSubmeshes) name += " (flat)";
+        if (isa != KernelIsa::Auto) name += std::string(" (") + kernelIsaName(kernels.isa) + " kernels)";
+    }
+
+    KernelIsa Isa() const
+    {
+        return kernels.isa;
+    }
+
+    const char* Name() const override
+    {
+        return name.c_str();
+    }
+
+    Mesh loadObjImplementation(const std::string& filename) override
+    {
+        if (CompressedObjStream::isCompressed(filename))
+        {
+            return loadCompressed(filename);
+        }
+
+        MappedFile file;
+        {
+            ScopedPhaseTimer timer(LoadPhase::OpenMap);
+            if (!file.open(filename)) {
+                std::cout << "Failed to open file\n";
+                std::terminate();
+            }
+        }
+
+        beginParse(filename, file.size);
+        parseLines(file.data, file.data + file.size);
+
+        return finishParse();
     }
 };
\ No newline at end of file
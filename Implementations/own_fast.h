@@ -1,6 +1,10 @@
 #pragma once
 
 #include "loader_template.h"
+#include "triangulation.h"
+#include "submeshes.h"
+
+#include <cstring>
 
 #pragma region Helper functions
 static inline int parseInt(const char* s, size_t n)
@@ -177,14 +181,18 @@ private:
 public:
     const char* Name() const override
     {
-        static std::string nameDedup = "own fast with vertex dedup";
-        static std::string nameRaw = "own fast";
+        static std::string suffix = triangulationMode == TriangulationMode::Auto ? "" : std::string(" (") + triangulationModeName() + ")";
+        static std::string nameDedup = "own fast with vertex dedup" + suffix;
+        static std::string nameRaw = "own fast" + suffix;
 
         return deduplicateVertices ? nameDedup.c_str() : nameRaw.c_str();
     }
 
     Mesh loadObjImplementation(const std::string& filename) override
     {
+        PhaseSwitcher phases;
+        phases.enter(LoadPhase::OpenMap);
+
         std::ifstream file(filename, std::ios::binary);
         if (!file.good())
         {
@@ -194,6 +202,7 @@ public:
 
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
+        std::vector<unsigned int> smoothingGroups;
 
         file.seekg(0, std::ios::end);
         size_t size = file.tellg();
@@ -202,6 +211,8 @@ public:
         std::vector<vec3> positions;
         std::vector<vec3> normals;
         std::vector<vec2> texcoords;
+        std::vector<unsigned int> faceCorners;
+        std::vector<vec3> facePoints;
 
         positions.reserve(size / 20);
         normals.reserve(size / 40);
@@ -212,8 +223,15 @@ public:
         std::string fileData(size, '\0');
         file.read(&fileData[0], size);
 
+        phases.enter(LoadPhase::Dedup);
         FastVertexCache cache(1 << 20);
 
+        // Groups are only recorded once the file uses them, faces before the first 's' are "off".
+        bool hasSmoothingGroups = false;
+        unsigned int smoothingGroup = 0;
+
+        SubmeshBuilder submeshBuilder;
+
         const char* data = fileData.c_str();
         const char* end = data + size;
 
@@ -227,6 +245,8 @@ public:
             if (lineEnd == lineStart) continue;
             if (*lineStart == '#') continue;
 
+            phases.enter(lineStart[0] == 'f' ? LoadPhase::FaceParse : LoadPhase::AttributeParse);
+
             // Parse vertices, normals, texcoords
             if (lineStart[0] == 'v' && (lineStart[1] == ' ' || lineStart[1] == '\t'))
             {
@@ -267,15 +287,33 @@ public:
                 float v = parseFloat(a, p - a);
                 texcoords.emplace_back(u, v);
             }
+            else if (lineStart[0] == 's' && (lineStart[1] == ' ' || lineStart[1] == '\t'))
+            {
+                const char* p = lineStart + 1;
+                while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
+                const char* a = p; while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+
+                smoothingGroup = (p - a == 3 && a[0] == 'o' && a[1] == 'f' && a[2] == 'f') ? 0 : (unsigned int)parseInt(a, p - a);
+
+                if (!hasSmoothingGroups)
+                {
+                    smoothingGroups.assign(indices.size() / 3, 0);
+                    hasSmoothingGroups = true;
+                }
+            }
             else if (lineStart[0] == 'f')
             {
                 const char* p = lineStart + 1;
-                while (*p == ' ' || *p == '\t') ++p;
 
-                int firstIndex = -1, prevIndex = -1;
+                faceCorners.clear();
+                facePoints.clear();
 
                 while (p < lineEnd)
                 {
+                    // Separators are skipped first, so a corner dropped below still moves p forward.
+                    while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
+                    if (p == lineEnd) break;
+
                     int pIdx = 0, tIdx = 0, nIdx = 0;
                     const char* a = p; while (p < lineEnd && *p != '/' && *p != ' ' && *p != '\t') ++p;
                     pIdx = parseInt(a, p - a);
@@ -325,21 +363,30 @@ public:
                         addVertex(vertices, positions, normals, texcoords, pIdx, nIdx, tIdx);
                     }
 
-                    if (firstIndex < 0) firstIndex = finalIndex;
-                    else if (prevIndex >= 0)
-                    {
-                        indices.push_back(firstIndex);
-                        indices.push_back(prevIndex);
-                        indices.push_back(finalIndex);
-                    }
+                    faceCorners.push_back(finalIndex);
+                    facePoints.push_back(positions[pIdx]);
+                }
 
-                    prevIndex = finalIndex;
+                size_t triangleCount = triangulateFace(faceCorners.data(), facePoints.data(), faceCorners.size(), indices);
 
-                    while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
-                }
+                if (hasSmoothingGroups) smoothingGroups.insert(smoothingGroups.end(), triangleCount, smoothingGroup);
+            }
+            else if ((lineStart[0] == 'o' || lineStart[0] == 'g') && (lineEnd - lineStart == 1 || lineStart[1] == ' ' || lineStart[1] == '\t' || lineStart[1] == '\r'))
+            {
+                if (lineStart[0] == 'o') submeshBuilder.setObject(lineStart + 1, lineEnd, indices.size());
+                else submeshBuilder.setGroup(lineStart + 1, lineEnd, indices.size());
+            }
+            else if (lineEnd - lineStart > 6 && std::memcmp(lineStart, "usemtl", 6) == 0)
+            {
+                submeshBuilder.setMaterial(lineStart + 6, lineEnd, indices.size());
             }
         }
 
-        return Mesh(vertices, indices);
+        phases.enter(LoadPhase::Assembly);
+
+        Mesh mesh(vertices, indices, smoothingGroups);
+        submeshBuilder.finish(mesh.indices(), mesh.smoothingGroups, mesh.submeshes);
+
+        return mesh;
     }
 };
\ No newline at end of file
@@ -0,0 +1,494 @@
+#pragma once
+
+#include "../types.h"
+#include "../Externals/fast_float.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define OBJ_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 and AVX-512 instructions in functions that ask for them, so those kernels
+// build in any configuration and run only after the CPU check. MSVC accepts the intrinsics anywhere.
+#if defined(OBJ_X86) && (defined(__GNUC__) || defined(__clang__))
+#define OBJ_TARGET_AVX2 __attribute__((target("avx2")))
+#define OBJ_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw")))
+#else
+#define OBJ_TARGET_AVX2
+#define OBJ_TARGET_AVX512
+#endif
+
+static const char* kernelIsaName(KernelIsa isa)
+{
+    switch (isa)
+    {
+        case KernelIsa::Auto: return "auto";
+        case KernelIsa::Scalar: return "scalar";
+        case KernelIsa::SSE2: return "sse2";
+        case KernelIsa::AVX2: return "avx2";
+        case KernelIsa::AVX512: return "avx512";
+        default: return "unknown";
+    }
+}
+
+// The text kernels of the obj parser. Every kernel may look ahead up to end, the end of the buffer,
+// but stops at the first byte that cannot continue what it parses, so a number never runs into the
+// next line. All variants give bit-identical results.
+struct ParseKernels
+{
+    KernelIsa isa;
+
+    // First '\n' in [p, end), or end.
+    const char* (*findNewline)(const char* p, const char* end);
+
+    // Up to count floats separated by spaces or tabs, stopping at lineEnd; missing values are left alone.
+    const char* (*parseFloats)(const char* p, const char* lineEnd, const char* end, float* values, int count);
+
+    // One face corner "v", "v/t", "v//n" or "v/t/n"; absent indices are 0.
+    const char* (*parseCorner)(const char* p, const char* lineEnd, const char* end, int* position, int* texcoord, int* normal);
+
+    // Lines in [p, end) that start with "v ", taking p as the start of a line.
+    size_t (*countVertexLines)(const char* p, const char* end);
+};
+
+#pragma region Helper functions
+static inline unsigned int lowestSetBit(uint64_t mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+#if defined(_M_X64)
+    _BitScanForward64(&index, mask);
+#else
+    if (_BitScanForward(&index, (unsigned long)mask)) return index;
+    _BitScanForward(&index, (unsigned long)(mask >> 32));
+    index += 32;
+#endif
+    return index;
+#else
+    return (unsigned int)__builtin_ctzll(mask);
+#endif
+}
+
+static inline unsigned int popCount(uint64_t mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+    return (unsigned int)__popcnt64(mask);
+#elif defined(_MSC_VER) && !defined(__clang__)
+    return (unsigned int)(__popcnt((unsigned int)mask) + __popcnt((unsigned int)(mask >> 32)));
+#else
+    return (unsigned int)__builtin_popcountll(mask);
+#endif
+}
+
+static const char* findNewlineScalar(const char* p, const char* end)
+{
+    while (p < end && *p != '\n') ++p;
+    return p;
+}
+
+// The vector versions look at three byte windows starting at q, q + 1 and q + 2 for "\n", 'v' and ' ',
+// then finish the last few bytes here.
+static inline size_t countVertexLinesTail(const char* q, const char* end)
+{
+    size_t count = 0;
+    for (; end - q > 2; ++q)
+    {
+        count += q[0] == '\n' && q[1] == 'v' && q[2] == ' ';
+    }
+    return count;
+}
+
+static size_t countVertexLinesScalar(const char* p, const char* end)
+{
+    if (end - p < 2) return 0;
+    return (p[0] == 'v' && p[1] == ' ') + countVertexLinesTail(p, end);
+}
+
+static inline const char* digitRunScalar(const char* p, const char* end)
+{
+    while (p < end && (unsigned char)(*p - '0') < 10) ++p;
+    return p;
+}
+
+// Numbers the fast path does not take, exponents, long mantissas, many decimals, nan and inf, go to fast_float.
+static inline const char* parseFloatFallback(const char* start, const char* end, float& value)
+{
+    const char* p = start + (start < end && *start == '+');
+    auto result = fast_float::from_chars(p, end, value);
+    if (result.ec != std::errc())
+    {
+        value = 0.0f;
+        return start;
+    }
+    return result.ptr;
+}
+
+// Sign, digits, optionally '.' and more digits. The digits are summed as one integer; when it fits in
+// a float's 24 bit significand and there are at most 10 decimals, both it and the power of ten are exact
+// floats, so the single float division rounds once and matches fast_float. Anything else goes to fast_float.
+template <const char* (*DigitRun)(const char*, const char*)>
+static inline const char* parseFloatWith(const char* start, const char* end, float& value)
+{
+    static const float powersOfTen[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+    const char* p = start;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    const char* integerEnd = DigitRun(p, end);
+    uint64_t mantissa = 0;
+    for (const char* d = p; d < integerEnd; ++d) mantissa = mantissa * 10 + (uint64_t)(*d - '0');
+
+    size_t digits = integerEnd - p;
+    size_t fraction = 0;
+    p = integerEnd;
+
+    if (p < end && *p == '.')
+    {
+        const char* fractionEnd = DigitRun(p + 1, end);
+        for (const char* d = p + 1; d < fractionEnd; ++d) mantissa = mantissa * 10 + (uint64_t)(*d - '0');
+
+        fraction = fractionEnd - (p + 1);
+        digits += fraction;
+        p = fractionEnd;
+    }
+
+    if (digits == 0 || digits > 19 || mantissa > (1ull << 24) || fraction > 10 || (p < end && (*p == 'e' || *p == 'E')))
+    {
+        return parseFloatFallback(start, end, value);
+    }
+
+    float result = (float)mantissa / powersOfTen[fraction];
+    value = negative ? -result : result;
+    return p;
+}
+
+template <const char* (*DigitRun)(const char*, const char*)>
+static inline const char* parseIntWith(const char* p, const char* end, int& value)
+{
+    bool negative = p < end && *p == '-';
+    if (negative) ++p;
+
+    const char* digitsEnd = DigitRun(p, end);
+    unsigned int result = 0;
+    for (const char* d = p; d < digitsEnd; ++d) result = result * 10 + (unsigned int)(*d - '0');
+
+    value = negative ? -(int)result : (int)result;
+    return digitsEnd;
+}
+
+template <const char* (*DigitRun)(const char*, const char*)>
+static inline const char* parseFloatsWith(const char* p, const char* lineEnd, const char* end, float* values, int count)
+{
+    for (int i = 0; i < count && p < lineEnd; ++i)
+    {
+        while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
+        if (p == lineEnd) break;
+
+        p = parseFloatWith<DigitRun>(p, end, values[i]);
+        while (p < lineEnd && *p != ' ' && *p != '\t') ++p; // anything after the number, e.g. '\r'
+    }
+    return p;
+}
+
+template <const char* (*DigitRun)(const char*, const char*)>
+static inline const char* parseCornerWith(const char* p, const char* lineEnd, const char* end, int* position, int* texcoord, int* normal)
+{
+    *position = *texcoord = *normal = 0;
+    p = parseIntWith<DigitRun>(p, end, *position);
+
+    if (p < lineEnd && *p == '/')
+    {
+        ++p;
+        if (p < lineEnd && *p != '/') p = parseIntWith<DigitRun>(p, end, *texcoord);
+        if (p < lineEnd && *p == '/') p = parseIntWith<DigitRun>(p + 1, end, *normal);
+    }
+
+    while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
+    return p;
+}
+
+static const char* parseFloatsScalar(const char* p, const char* lineEnd, const char* end, float* values, int count)
+{
+    return parseFloatsWith<digitRunScalar>(p, lineEnd, end, values, count);
+}
+
+static const char* parseCornerScalar(const char* p, const char* lineEnd, const char* end, int* position, int* texcoord, int* normal)
+{
+    return parseCornerWith<digitRunScalar>(p, lineEnd, end, position, texcoord, normal);
+}
+
+#ifdef OBJ_SSE2
+// Adding 128 - '0' moves '0'..'9' to the bottom of the signed byte range, so one signed compare finds
+// the digits; SSE2 has no unsigned byte compare.
+static const char* findNewlineSse2(const char* p, const char* end)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16)
+    {
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), newline));
+        if (mask) return p + lowestSetBit(mask);
+    }
+    return findNewlineScalar(p, end);
+}
+
+static inline const char* digitRunSse2(const char* p, const char* end)
+{
+    const __m128i shift = _mm_set1_epi8((char)(128 - '0'));
+    const __m128i limit = _mm_set1_epi8((char)(-128 + 10));
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i shifted = _mm_add_epi8(_mm_loadu_si128((const __m128i*)p), shift);
+        unsigned int other = ~(unsigned int)_mm_movemask_epi8(_mm_cmplt_epi8(shifted, limit)) & 0xffff;
+        if (other) return p + lowestSetBit(other);
+    }
+    return digitRunScalar(p, end);
+}
+
+static const char* parseFloatsSse2(const char* p, const char* lineEnd, const char* end, float* values, int count)
+{
+    return parseFloatsWith<digitRunSse2>(p, lineEnd, end, values, count);
+}
+
+static const char* parseCornerSse2(const char* p, const char* lineEnd, const char* end, int* position, int* texcoord, int* normal)
+{
+    return parseCornerWith<digitRunSse2>(p, lineEnd, end, position, texcoord, normal);
+}
+
+static size_t countVertexLinesSse2(const char* p, const char* end)
+{
+    if (end - p < 2) return 0;
+
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i v = _mm_set1_epi8('v');
+    const __m128i space = _mm_set1_epi8(' ');
+
+    size_t count = p[0] == 'v' && p[1] == ' ';
+    const char* q = p;
+    for (; end - q >= 18; q += 16)
+    {
+        __m128i starts = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)q), newline),
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(q + 1)), v),
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(q + 2)), space)));
+        count += popCount((unsigned int)_mm_movemask_epi8(starts));
+    }
+    return count + countVertexLinesTail(q, end);
+}
+#endif
+
+#ifdef OBJ_X86
+OBJ_TARGET_AVX2 static const char* findNewlineAvx2(const char* p, const char* end)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; end - p >= 32; p += 32)
+    {
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), newline));
+        if (mask) return p + lowestSetBit(mask);
+    }
+    return findNewlineScalar(p, end);
+}
+
+OBJ_TARGET_AVX2 static inline const char* digitRunAvx2(const char* p, const char* end)
+{
+    const __m256i shift = _mm256_set1_epi8((char)(128 - '0'));
+    const __m256i limit = _mm256_set1_epi8((char)(-128 + 10));
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i shifted = _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)p), shift);
+        unsigned int other = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(limit, shifted));
+        if (other) return p + lowestSetBit(other);
+    }
+    return digitRunScalar(p, end);
+}
+
+OBJ_TARGET_AVX2 static const char* parseFloatsAvx2(const char* p, const char* lineEnd, const char* end, float* values, int count)
+{
+    return parseFloatsWith<digitRunAvx2>(p, lineEnd, end, values, count);
+}
+
+OBJ_TARGET_AVX2 static const char* parseCornerAvx2(const char* p, const char* lineEnd, const char* end, int* position, int* texcoord, int* normal)
+{
+    return parseCornerWith<digitRunAvx2>(p, lineEnd, end, position, texcoord, normal);
+}
+
+OBJ_TARGET_AVX2 static size_t countVertexLinesAvx2(const char* p, const char* end)
+{
+    if (end - p < 2) return 0;
+
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i v = _mm256_set1_epi8('v');
+    const __m256i space = _mm256_set1_epi8(' ');
+
+    size_t count = p[0] == 'v' && p[1] == ' ';
+    const char* q = p;
+    for (; end - q >= 34; q += 32)
+    {
+        __m256i starts = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)q), newline),
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(q + 1)), v),
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(q + 2)), space)));
+        count += popCount((unsigned int)_mm256_movemask_epi8(starts));
+    }
+    return count + countVertexLinesTail(q, end);
+}
+
+// Masked loads do not fault past the mask, so the last partial block stays in vector code too.
+OBJ_TARGET_AVX512 static inline __mmask64 loadMask64(const char* p, const char* end)
+{
+    size_t left = (size_t)(end - p);
+    return left >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << left) - 1);
+}
+
+OBJ_TARGET_AVX512 static const char* findNewlineAvx512(const char* p, const char* end)
+{
+    const __m512i newline = _mm512_set1_epi8('\n');
+    for (; p < end; p += 64)
+    {
+        __mmask64 valid = loadMask64(p, end);
+        __mmask64 mask = _mm512_mask_cmpeq_epi8_mask(valid, _mm512_maskz_loadu_epi8(valid, p), newline);
+        if (mask) return p + lowestSetBit(mask);
+    }
+    return end;
+}
+
+OBJ_TARGET_AVX512 static inline const char* digitRunAvx512(const char* p, const char* end)
+{
+    const __m512i zero = _mm512_set1_epi8('0');
+    const __m512i ten = _mm512_set1_epi8(10);
+    for (; p < end; p += 64)
+    {
+        __mmask64 valid = loadMask64(p, end);
+        __m512i digits = _mm512_sub_epi8(_mm512_maskz_loadu_epi8(valid, p), zero);
+        __mmask64 other = ~_mm512_mask_cmplt_epu8_mask(valid, digits, ten);
+        if (other) return std::min(end, p + lowestSetBit(other));
+    }
+    return end;
+}
+
+OBJ_TARGET_AVX512 static const char* parseFloatsAvx512(const char* p, const char* lineEnd, const char* end, float* values, int count)
+{
+    return parseFloatsWith<digitRunAvx512>(p, lineEnd, end, values, count);
+}
+
+OBJ_TARGET_AVX512 static const char* parseCornerAvx512(const char* p, const char* lineEnd, const char* end, int* position, int* texcoord, int* normal)
+{
+    return parseCornerWith<digitRunAvx512>(p, lineEnd, end, position, texcoord, normal);
+}
+
+OBJ_TARGET_AVX512 static size_t countVertexLinesAvx512(const char* p, const char* end)
+{
+    if (end - p < 2) return 0;
+
+    const __m512i newline = _mm512_set1_epi8('\n');
+    const __m512i v = _mm512_set1_epi8('v');
+    const __m512i space = _mm512_set1_epi8(' ');
+
+    size_t count = p[0] == 'v' && p[1] == ' ';
+    for (const char* q = p; end - q > 2; q += 64)
+    {
+        // Lanes whose third byte is still inside the buffer.
+        __mmask64 valid = loadMask64(q + 2, end);
+        __mmask64 starts = _mm512_mask_cmpeq_epi8_mask(valid, _mm512_maskz_loadu_epi8(valid, q), newline);
+        starts = _mm512_mask_cmpeq_epi8_mask(starts, _mm512_maskz_loadu_epi8(valid, q + 1), v);
+        starts = _mm512_mask_cmpeq_epi8_mask(starts, _mm512_maskz_loadu_epi8(valid, q + 2), space);
+        count += popCount(starts);
+    }
+    return count;
+}
+
+static void cpuid(int leaf, int subleaf, unsigned int registers[4])
+{
+#ifdef _MSC_VER
+    __cpuidex((int*)registers, leaf, subleaf);
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+static uint64_t readXcr0()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((uint64_t)high << 32) | low;
+#endif
+}
+#endif
+
+// Widest kernel set this CPU and OS can run, probed once. AVX and AVX-512 also need the OS to save
+// the wider registers, which XCR0 reports.
+static KernelIsa detectKernelIsa()
+{
+#ifdef OBJ_X86
+    unsigned int registers[4];
+    cpuid(0, 0, registers);
+    unsigned int maxLeaf = registers[0];
+
+    cpuid(1, 0, registers);
+    bool sse2 = (registers[3] >> 26) & 1;
+    bool osxsave = (registers[2] >> 27) & 1;
+    bool avx = (registers[2] >> 28) & 1;
+
+    uint64_t xcr0 = osxsave ? readXcr0() : 0;
+    bool ymmState = (xcr0 & 0x6) == 0x6;
+    bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+    bool avx2 = false, avx512 = false;
+    if (maxLeaf >= 7)
+    {
+        cpuid(7, 0, registers);
+        avx2 = avx && ymmState && ((registers[1] >> 5) & 1);
+        avx512 = avx2 && zmmState && ((registers[1] >> 16) & 1) && ((registers[1] >> 30) & 1);
+    }
+
+    if (avx512) return KernelIsa::AVX512;
+    if (avx2) return KernelIsa::AVX2;
+#ifdef OBJ_SSE2
+    if (sse2) return KernelIsa::SSE2;
+#endif
+#endif
+    return KernelIsa::Scalar;
+}
+
+static KernelIsa supportedKernelIsa()
+{
+    static const KernelIsa supported = detectKernelIsa();
+    return supported;
+}
+#pragma endregion
+
+// Kernels for a requested instruction set. Auto picks the widest supported one; asking for more than
+// the CPU has falls back to the widest supported set, with a note, rather than faulting.
+static ParseKernels selectParseKernels(KernelIsa requested)
+{
+    KernelIsa supported = supportedKernelIsa();
+    KernelIsa isa = requested == KernelIsa::Auto ? supported : requested;
+
+    if ((int)isa > (int)supported)
+    {
+        std::cout << kernelIsaName(isa) << " parse kernels are not supported here, using " << kernelIsaName(supported) << "\n";
+        isa = supported;
+    }
+
+    switch (isa)
+    {
+#ifdef OBJ_X86
+        case KernelIsa::AVX512: return { isa, findNewlineAvx512, parseFloatsAvx512, parseCornerAvx512, countVertexLinesAvx512 };
+        case KernelIsa::AVX2: return { isa, findNewlineAvx2, parseFloatsAvx2, parseCornerAvx2, countVertexLinesAvx2 };
+#endif
+#ifdef OBJ_SSE2
+        case KernelIsa::SSE2: return { isa, findNewlineSse2, parseFloatsSse2, parseCornerSse2, countVertexLinesSse2 };
+#endif
+        default: return { KernelIsa::Scalar, findNewlineScalar, parseFloatsScalar, parseCornerScalar, countVertexLinesScalar };
+    }
+}
@@ -0,0 +1,457 @@
+#pragma once
+
+#include "loader_template.h"
+#include "triangulation.h"
+#include "../Externals/fast_float.h"
+
+#include <cstring>
+
+#pragma region PLY header
+enum class PlyFormat { Ascii, BinaryLittleEndian, BinaryBigEndian };
+enum class PlyType { Invalid, Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+struct PlyProperty
+{
+    std::string name;
+    PlyType type = PlyType::Invalid;
+    PlyType countType = PlyType::Invalid; // set for list properties
+};
+
+struct PlyElement
+{
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+};
+
+static PlyType plyTypeFromName(const std::string& name)
+{
+    if (name == "char" || name == "int8") return PlyType::Int8;
+    if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+    if (name == "short" || name == "int16") return PlyType::Int16;
+    if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+    if (name == "int" || name == "int32") return PlyType::Int32;
+    if (name == "uint" || name == "uint32") return PlyType::UInt32;
+    if (name == "float" || name == "float32") return PlyType::Float32;
+    if (name == "double" || name == "float64") return PlyType::Float64;
+    return PlyType::Invalid;
+}
+
+static size_t plyTypeSize(PlyType type)
+{
+    switch (type)
+    {
+        case PlyType::Int8: case PlyType::UInt8: return 1;
+        case PlyType::Int16: case PlyType::UInt16: return 2;
+        case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+        case PlyType::Float64: return 8;
+        default: return 0;
+    }
+}
+
+struct PlyHeader
+{
+    PlyFormat format = PlyFormat::Ascii;
+    std::vector<PlyElement> elements;
+    size_t dataOffset = 0;
+
+    bool parse(const char* data, size_t size)
+    {
+        const char* end = data + size;
+        const char* p = data;
+        bool sawFormat = false;
+
+        auto nextLine = [&]()
+        {
+            const char* start = p;
+            while (p < end && *p != '\n') ++p;
+            std::string line(start, p);
+            if (p < end) ++p;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            return line;
+        };
+
+        if (nextLine() != "ply") return false;
+
+        while (p < end)
+        {
+            std::istringstream line(nextLine());
+            std::string keyword;
+            line >> keyword;
+
+            if (keyword == "format")
+            {
+                std::string name;
+                line >> name;
+                if (name == "ascii") format = PlyFormat::Ascii;
+                else if (name == "binary_little_endian") format = PlyFormat::BinaryLittleEndian;
+                else if (name == "binary_big_endian") format = PlyFormat::BinaryBigEndian;
+                else return false;
+                sawFormat = true;
+            }
+            else if (keyword == "element")
+            {
+                PlyElement element;
+                line >> element.name >> element.count;
+                if (!line) return false;
+                elements.push_back(element);
+            }
+            else if (keyword == "property")
+            {
+                if (elements.empty()) return false;
+
+                PlyProperty property;
+                std::string type;
+                line >> type;
+
+                if (type == "list")
+                {
+                    std::string countType, itemType;
+                    line >> countType >> itemType;
+                    property.countType = plyTypeFromName(countType);
+                    property.type = plyTypeFromName(itemType);
+                    if (property.countType == PlyType::Invalid) return false;
+                }
+                else
+                {
+                    property.type = plyTypeFromName(type);
+                }
+
+                line >> property.name;
+                if (!line || property.type == PlyType::Invalid) return false;
+                elements.back().properties.push_back(property);
+            }
+            else if (keyword == "end_header")
+            {
+                dataOffset = p - data;
+                return sawFormat;
+            }
+        }
+
+        return false;
+    }
+};
+#pragma endregion
+
+#pragma region Helper functions
+// Reads one value of a fixed width type, swapping its bytes for big endian files.
+template <typename V>
+static inline bool readPlyScalar(const char*& p, const char* end, bool swap, V& value)
+{
+    if ((size_t)(end - p) < sizeof(V)) return false;
+
+    unsigned char bytes[sizeof(V)];
+    std::memcpy(bytes, p, sizeof(V));
+    p += sizeof(V);
+
+    if (swap) std::reverse(bytes, bytes + sizeof(V));
+    std::memcpy(&value, bytes, sizeof(V));
+    return true;
+}
+
+// Reads one binary value of the given type and converts it; swap handles big endian files. Fails
+// without reading when the value would run past end.
+template <typename T>
+static inline bool readPlyBinary(const char*& p, const char* end, PlyType type, bool swap, T& value)
+{
+    switch (type)
+    {
+        case PlyType::Int8: { int8_t v; if (!readPlyScalar(p, end, swap, v)) return false; value = (T)v; return true; }
+        case PlyType::UInt8: { uint8_t v; if (!readPlyScalar(p, end, swap, v)) return false; value = (T)v; return true; }
+        case PlyType::Int16: { int16_t v; if (!readPlyScalar(p, end, swap, v)) return false; value = (T)v; return true; }
+        case PlyType::UInt16: { uint16_t v; if (!readPlyScalar(p, end, swap, v)) return false; value = (T)v; return true; }
+        case PlyType::Int32: { int32_t v; if (!readPlyScalar(p, end, swap, v)) return false; value = (T)v; return true; }
+        case PlyType::UInt32: { uint32_t v; if (!readPlyScalar(p, end, swap, v)) return false; value = (T)v; return true; }
+        case PlyType::Float32: { float v; if (!readPlyScalar(p, end, swap, v)) return false; value = (T)v; return true; }
+        case PlyType::Float64: { double v; if (!readPlyScalar(p, end, swap, v)) return false; value = (T)v; return true; }
+        default: return false;
+    }
+}
+
+// Reads the next whitespace separated token of an ASCII body as a number.
+template <typename T>
+static inline T readPlyAscii(const char*& p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+
+    double value = 0.0;
+    auto result = fast_float::from_chars(p, end, value);
+    p = result.ptr;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') ++p;
+
+    return (T)value;
+}
+
+// One value of either body format. ASCII bodies stop at end on their own and read as 0 past it.
+template <bool Ascii, typename T>
+static inline bool readPlyValue(const char*& p, const char* end, PlyType type, bool swap, T& value)
+{
+    if (Ascii)
+    {
+        value = readPlyAscii<T>(p, end);
+        return true;
+    }
+    return readPlyBinary<T>(p, end, type, swap, value);
+}
+
+// A list count read from the file, checked against the bytes left before anything loops over it. An
+// ASCII item takes at least one byte.
+template <bool Ascii>
+static inline bool readPlyListCount(const char*& p, const char* end, const PlyProperty& property, bool swap, size_t& count)
+{
+    if (!readPlyValue<Ascii>(p, end, property.countType, swap, count)) return false;
+
+    size_t itemBytes = Ascii ? 1 : plyTypeSize(property.type);
+    return itemBytes != 0 && count <= (size_t)(end - p) / itemBytes;
+}
+
+// Vertex slot a property fills: 0-2 position, 3-5 normal, 6-7 uv, -1 ignored.
+static int plyVertexSlot(const std::string& name)
+{
+    static const char* names[][3] = {
+        { "x" }, { "y" }, { "z" },
+        { "nx" }, { "ny" }, { "nz" },
+        { "s", "u", "texture_u" }, { "t", "v", "texture_v" }
+    };
+
+    for (int slot = 0; slot < 8; ++slot)
+    {
+        for (const char* candidate : names[slot])
+        {
+            if (candidate && name == candidate) return slot;
+        }
+    }
+
+    return -1;
+}
+#pragma endregion
+
+// Loads ASCII and binary PLY from a mapped file. Binary vertex data whose layout matches Vertex
+// (eight little endian floats in x y z nx ny nz s t order) is copied in one block; any other layout is
+// converted property by property. Polygons go through the same triangulation as the obj loaders.
+class PlyLoader : public LoaderTemplate
+{
+private:
+    std::string name;
+    std::string extension;
+
+    template <bool Ascii>
+    static bool readVertices(const PlyElement& element, const char*& p, const char* end, bool swap, Mesh& mesh)
+    {
+        std::vector<int> slots;
+        bool packedFloats = !Ascii && !swap && element.properties.size() == 8;
+
+        for (size_t i = 0; i < element.properties.size(); ++i)
+        {
+            const PlyProperty& property = element.properties[i];
+            slots.push_back(property.countType == PlyType::Invalid ? plyVertexSlot(property.name) : -1);
+            packedFloats &= property.type == PlyType::Float32 && property.countType == PlyType::Invalid && slots[i] == (int)i;
+        }
+
+        mesh.vertices.resize(element.count);
+
+        if (packedFloats && (size_t)(end - p) >= element.count * sizeof(Vertex))
+        {
+            std::memcpy(mesh.vertices.data(), p, element.count * sizeof(Vertex));
+            p += element.count * sizeof(Vertex);
+            return true;
+        }
+
+        for (size_t v = 0; v < element.count; ++v)
+        {
+            float values[8] = {};
+
+            for (size_t i = 0; i < element.properties.size(); ++i)
+            {
+                const PlyProperty& property = element.properties[i];
+
+                if (property.countType != PlyType::Invalid)
+                {
+                    size_t count;
+                    if (!readPlyListCount<Ascii>(p, end, property, swap, count)) return false;
+
+                    float item;
+                    for (size_t k = 0; k < count; ++k)
+                    {
+                        if (!readPlyValue<Ascii>(p, end, property.type, swap, item)) return false;
+                    }
+                    continue;
+                }
+
+                float value;
+                if (!readPlyValue<Ascii>(p, end, property.type, swap, value)) return false;
+                if (slots[i] >= 0) values[slots[i]] = value;
+            }
+
+            mesh.vertices[v] = Vertex(values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7]);
+        }
+
+        return true;
+    }
+
+    template <bool Ascii>
+    static bool readFaces(const PlyElement& element, const char*& p, const char* end, bool swap, Mesh& mesh)
+    {
+        std::vector<unsigned int> corners;
+        std::vector<vec3> points;
+        std::vector<unsigned int>& indices = mesh.indices();
+        indices.reserve(element.count * 3);
+
+        for (size_t f = 0; f < element.count; ++f)
+        {
+            for (const PlyProperty& property : element.properties)
+            {
+                bool isIndices = property.countType != PlyType::Invalid
+                    && (property.name == "vertex_indices" || property.name == "vertex_index");
+
+                if (property.countType == PlyType::Invalid)
+                {
+                    double ignored;
+                    if (!readPlyValue<Ascii>(p, end, property.type, swap, ignored)) return false;
+                    continue;
+                }
+
+                size_t count;
+                if (!readPlyListCount<Ascii>(p, end, property, swap, count)) return false;
+                corners.clear();
+                points.clear();
+
+                for (size_t k = 0; k < count; ++k)
+                {
+                    unsigned int index;
+                    if (!readPlyValue<Ascii>(p, end, property.type, swap, index)) return false;
+                    if (!isIndices || index >= mesh.vertices.size()) continue;
+
+                    corners.push_back(index);
+                    points.push_back(mesh.vertices[index].pos);
+                }
+
+                if (isIndices) triangulateFace(corners.data(), points.data(), corners.size(), indices);
+            }
+        }
+
+        return true;
+    }
+
+    template <bool Ascii>
+    static bool skipElement(const PlyElement& element, const char*& p, const char* end, bool swap)
+    {
+        for (size_t r = 0; r < element.count && p < end; ++r)
+        {
+            for (const PlyProperty& property : element.properties)
+            {
+                size_t count = 1;
+                if (property.countType != PlyType::Invalid && !readPlyListCount<Ascii>(p, end, property, swap, count)) return false;
+
+                double ignored;
+                for (size_t k = 0; k < count; ++k)
+                {
+                    if (!readPlyValue<Ascii>(p, end, property.type, swap, ignored)) return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Bytes one record of an element takes in a binary file, or 0 when it holds lists.
+    static size_t fixedRecordSize(const PlyElement& element)
+    {
+        size_t size = 0;
+        for (const PlyProperty& property : element.properties)
+        {
+            if (property.countType != PlyType::Invalid) return 0;
+            size += plyTypeSize(property.type);
+        }
+        return size;
+    }
+
+    template <bool Ascii>
+    static bool readBody(const PlyHeader& header, const char* p, const char* end, Mesh& mesh)
+    {
+        bool swap = header.format == PlyFormat::BinaryBigEndian;
+
+        for (const PlyElement& element : header.elements)
+        {
+            // A truncated binary file must not be read past its end.
+            size_t recordSize = Ascii ? 0 : fixedRecordSize(element);
+            if (recordSize && (size_t)(end - p) / recordSize < element.count) return false;
+
+            // Records with lists take at least a byte each, which bounds the count before anything
+            // is sized from it.
+            if (!element.properties.empty() && element.count > (size_t)(end - p)) return false;
+
+            bool ok;
+            if (element.name == "vertex")
+            {
+                ScopedPhaseTimer timer(LoadPhase::AttributeParse);
+                ok = readVertices<Ascii>(element, p, end, swap, mesh);
+            }
+            else if (element.name == "face")
+            {
+                ScopedPhaseTimer timer(LoadPhase::FaceParse);
+                ok = readFaces<Ascii>(element, p, end, swap, mesh);
+            }
+            else
+            {
+                ScopedPhaseTimer timer(LoadPhase::Scan);
+                ok = skipElement<Ascii>(element, p, end, swap);
+            }
+
+            if (!ok || p > end) return false;
+        }
+
+        return true;
+    }
+
+public:
+    // extension selects which converted copy of each obj this instance reads, e.g. ".ply".
+    PlyLoader(const std::string& name, const std::string& extension) : name(name), extension(extension) {}
+
+    const char* Name() const override
+    {
+        return name.c_str();
+    }
+
+    std::string InputPath(const std::string& objPath) const override
+    {
+        return interchangePath(objPath, extension.c_str());
+    }
+
+    Mesh loadObjImplementation(const std::string& filename) override
+    {
+        MappedFile file;
+        PlyHeader header;
+        Mesh mesh;
+
+        bool opened;
+        {
+            ScopedPhaseTimer timer(LoadPhase::OpenMap);
+            opened = file.open(filename);
+        }
+        {
+            ScopedPhaseTimer timer(LoadPhase::Scan);
+            opened = opened && header.parse(file.data, file.size);
+        }
+
+        if (!opened)
+        {
+            std::cout << "Failed to open ply file " << filename << "\n";
+            return mesh;
+        }
+
+        const char* body = file.data + header.dataOffset;
+        const char* end = file.data + file.size;
+
+        bool ok = header.format == PlyFormat::Ascii
+            ? readBody<true>(header, body, end, mesh)
+            : readBody<false>(header, body, end, mesh);
+
+        if (!ok)
+        {
+            std::cout << "Truncated ply file " << filename << "\n";
+        }
+
+        return mesh;
+    }
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "loader_template.h"
+
+#include <cstring>
+
+// Loads binary STL from a mapped file. STL stores every triangle on its own, so each record becomes
+// three vertices carrying the facet normal and the index buffer simply counts up. The file size must
+// match the triangle count in the header exactly; ASCII STL is not supported.
+class StlLoader : public LoaderTemplate
+{
+public:
+    const char* Name() const override
+    {
+        return "Binary STL";
+    }
+
+    std::string InputPath(const std::string& objPath) const override
+    {
+        return interchangePath(objPath, ".stl");
+    }
+
+    Mesh loadObjImplementation(const std::string& filename) override
+    {
+        const size_t headerBytes = 80 + sizeof(uint32_t);
+        const size_t triangleBytes = 50;
+
+        MappedFile file;
+        Mesh mesh;
+
+        bool opened;
+        {
+            ScopedPhaseTimer timer(LoadPhase::OpenMap);
+            opened = file.open(filename);
+        }
+
+        if (!opened || file.size < headerBytes)
+        {
+            std::cout << "Failed to open stl file " << filename << "\n";
+            return mesh;
+        }
+
+        uint32_t triangleCount;
+        std::memcpy(&triangleCount, file.data + 80, sizeof(triangleCount));
+
+        if (file.size != headerBytes + (size_t)triangleCount * triangleBytes)
+        {
+            std::cout << "Not a binary stl file " << filename << "\n";
+            return mesh;
+        }
+
+        ScopedPhaseTimer timer(LoadPhase::Parse);
+
+        mesh.vertices.resize((size_t)triangleCount * 3);
+        std::vector<unsigned int>& indices = mesh.indices();
+        indices.resize((size_t)triangleCount * 3);
+
+        const char* p = file.data + headerBytes;
+        for (size_t t = 0; t < triangleCount; ++t, p += triangleBytes)
+        {
+            float record[12];
+            std::memcpy(record, p, sizeof(record));
+
+            vec3 normal(record[0], record[1], record[2]);
+            for (size_t c = 0; c < 3; ++c)
+            {
+                const float* corner = record + 3 + c * 3;
+                mesh.vertices[t * 3 + c] = Vertex(vec3(corner[0], corner[1], corner[2]), normal);
+                indices[t * 3 + c] = (unsigned int)(t * 3 + c);
+            }
+        }
+
+        return mesh;
+    }
+};
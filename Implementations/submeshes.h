@@ -0,0 +1,167 @@
+#pragma once
+
+#include "../types.h"
+
+// Collects the draw ranges of a mesh while it is parsed. Only 'o', 'g' and 'usemtl' statements reach
+// it, faces cost nothing extra: a statement starts a new run at the current index count. At the end a
+// key that came back later in the file has its runs moved together, so every object/group/material
+// is a single contiguous range and a renderer can issue one draw per submesh without sorting.
+class SubmeshBuilder
+{
+private:
+    struct Run
+    {
+        unsigned int key;
+        size_t indexOffset;
+    };
+
+    std::vector<Submesh> keys;
+    std::unordered_map<std::string, unsigned int> lookup;
+    std::vector<Run> runs;
+    std::string object, group, material;
+    std::string keyBuffer;
+
+    static void assignName(std::string& name, const char* begin, const char* end)
+    {
+        while (begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) --end;
+        name.assign(begin, end);
+    }
+
+    void switchKey(size_t indexCount)
+    {
+        keyBuffer = object + '\n' + group + '\n' + material;
+
+        unsigned int key;
+        auto found = lookup.find(keyBuffer);
+        if (found == lookup.end())
+        {
+            key = (unsigned int)keys.size();
+            lookup.emplace(keyBuffer, key);
+            keys.push_back({ object, group, material, 0, 0 });
+        }
+        else
+        {
+            key = found->second;
+        }
+
+        // Statements without faces in between, e.g. 'g' straight followed by 'usemtl', only relabel the run.
+        if (!runs.empty() && runs.back().indexOffset == indexCount)
+        {
+            runs.back().key = key;
+            if (runs.size() > 1 && runs[runs.size() - 2].key == key) runs.pop_back();
+        }
+        else if (runs.empty() || runs.back().key != key)
+        {
+            runs.push_back({ key, indexCount });
+        }
+    }
+
+    // Faces before the first statement belong to the unnamed submesh.
+    void beginStatement(size_t indexCount)
+    {
+        if (runs.empty() && indexCount > 0) switchKey(0);
+    }
+
+public:
+    void reset()
+    {
+        keys.clear();
+        lookup.clear();
+        runs.clear();
+        object.clear();
+        group.clear();
+        material.clear();
+    }
+
+    void setObject(const char* begin, const char* end, size_t indexCount)
+    {
+        beginStatement(indexCount);
+        assignName(object, begin, end);
+        switchKey(indexCount);
+    }
+
+    void setGroup(const char* begin, const char* end, size_t indexCount)
+    {
+        beginStatement(indexCount);
+        assignName(group, begin, end);
+        switchKey(indexCount);
+    }
+
+    void setMaterial(const char* begin, const char* end, size_t indexCount)
+    {
+        beginStatement(indexCount);
+        assignName(material, begin, end);
+        switchKey(indexCount);
+    }
+
+    // Writes the ranges to submeshes in order of first appearance. Triangles, and their smoothing groups
+    // when there is one per triangle, are only moved when some key has more than one run.
+    void finish(std::vector<unsigned int>& indices, std::vector<unsigned int>& smoothingGroups, std::vector<Submesh>& submeshes)
+    {
+        submeshes.clear();
+        if (runs.empty()) return;
+
+        size_t total = indices.size();
+        std::vector<unsigned int> runCount(keys.size(), 0);
+        std::vector<unsigned int> order;
+        bool contiguous = true;
+
+        for (size_t r = 0; r < runs.size(); ++r)
+        {
+            size_t end = r + 1 < runs.size() ? runs[r + 1].indexOffset : total;
+            if (end == runs[r].indexOffset) continue;
+
+            if (runCount[runs[r].key]++ == 0) order.push_back(runs[r].key);
+            else contiguous = false;
+
+            keys[runs[r].key].indexCount += end - runs[r].indexOffset;
+        }
+
+        if (contiguous)
+        {
+            for (size_t r = 0; r < runs.size(); ++r)
+            {
+                // Only the last run can be empty, a statement after the final face.
+                if (runs[r].indexOffset == total) continue;
+
+                Submesh& key = keys[runs[r].key];
+                key.indexOffset = runs[r].indexOffset;
+                submeshes.push_back(key);
+            }
+            return;
+        }
+
+        std::vector<size_t> cursor(keys.size(), 0);
+        size_t offset = 0;
+        for (unsigned int k : order)
+        {
+            keys[k].indexOffset = offset;
+            cursor[k] = offset;
+            offset += keys[k].indexCount;
+            submeshes.push_back(keys[k]);
+        }
+
+        bool moveGroups = smoothingGroups.size() * 3 == total;
+        std::vector<unsigned int> movedIndices(total);
+        std::vector<unsigned int> movedGroups(moveGroups ? smoothingGroups.size() : 0);
+
+        for (size_t r = 0; r < runs.size(); ++r)
+        {
+            size_t begin = runs[r].indexOffset;
+            size_t end = r + 1 < runs.size() ? runs[r + 1].indexOffset : total;
+            size_t& target = cursor[runs[r].key];
+
+            std::copy(indices.begin() + begin, indices.begin() + end, movedIndices.begin() + target);
+            if (moveGroups)
+            {
+                std::copy(smoothingGroups.begin() + begin / 3, smoothingGroups.begin() + end / 3, movedGroups.begin() + target / 3);
+            }
+
+            target += end - begin;
+        }
+
+        indices.swap(movedIndices);
+        if (moveGroups) smoothingGroups.swap(movedGroups);
+    }
+};
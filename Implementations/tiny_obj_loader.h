@@ -24,24 +24,31 @@ public:
         std::vector<tinyobj::material_t> materials;
         std::string warn, err;
 
-        bool ret = tinyobj::LoadObj(
-            &attrib,
-            &shapes,
-            &materials,
-            &warn,
-            &err,
-            filename.c_str(),
-            nullptr,
-            true
-        );
+        bool ret;
+        {
+            ScopedPhaseTimer timer(LoadPhase::Parse);
+            ret = tinyobj::LoadObj(
+                &attrib,
+                &shapes,
+                &materials,
+                &warn,
+                &err,
+                filename.c_str(),
+                nullptr,
+                true
+            );
+        }
 
         if (!ret) {
             if (!err.empty()) std::cerr << "TinyObj error: " << err << std::endl;
             std::terminate();
         }
 
+        ScopedPhaseTimer timer(LoadPhase::WrapperConversion);
+
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
+        std::vector<unsigned int> smoothingGroups;
 
         // Pre-allocate based on total number of indices for speed
         size_t totalIndices = 0;
@@ -92,6 +99,19 @@ public:
             }
         }
 
-        return Mesh(vertices, indices);
+        // Faces are triangulated, so the per-face ids map one to one onto our triangles.
+        bool hasSmoothingGroups = false;
+        for (const auto& shape : shapes)
+            for (unsigned int id : shape.mesh.smoothing_group_ids)
+                hasSmoothingGroups |= id != 0;
+
+        if (hasSmoothingGroups)
+        {
+            smoothingGroups.reserve(totalIndices / 3);
+            for (const auto& shape : shapes)
+                smoothingGroups.insert(smoothingGroups.end(), shape.mesh.smoothing_group_ids.begin(), shape.mesh.smoothing_group_ids.end());
+        }
+
+        return Mesh(vertices, indices, smoothingGroups);
     }
 };
\ No newline at end of file
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "../types.h"
+
+#pragma region Helper functions
+// Newell's method, robust for non-planar and concave polygons.
+static inline vec3 polygonNormal(const vec3* points, size_t count)
+{
+    vec3 normal(0.0f);
+
+    for (size_t i = 0, j = count - 1; i < count; j = i++)
+    {
+        normal.x += (points[j].y - points[i].y) * (points[j].z + points[i].z);
+        normal.y += (points[j].z - points[i].z) * (points[j].x + points[i].x);
+        normal.z += (points[j].x - points[i].x) * (points[j].y + points[i].y);
+    }
+
+    return normal;
+}
+
+// A polygon is convex when every turn goes the same way around its normal.
+static inline bool isConvexPolygon(const vec3* points, size_t count, const vec3& normal)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const vec3& a = points[i];
+        const vec3& b = points[(i + 1) % count];
+        const vec3& c = points[(i + 2) % count];
+
+        if (vec3::dot(vec3::cross(b - a, c - b), normal) < 0.0f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static inline float cross2(const vec2& a, const vec2& b, const vec2& c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+static inline bool pointInTriangle(const vec2& p, const vec2& a, const vec2& b, const vec2& c)
+{
+    return cross2(a, b, p) >= 0.0f && cross2(b, c, p) >= 0.0f && cross2(c, a, p) >= 0.0f;
+}
+
+static inline void triangulateFan(const unsigned int* corners, size_t count, std::vector<unsigned int>& indices)
+{
+    for (size_t i = 2; i < count; ++i)
+    {
+        indices.push_back(corners[0]);
+        indices.push_back(corners[i - 1]);
+        indices.push_back(corners[i]);
+    }
+}
+
+// O(n^2) ear clipping on the polygon projected onto its dominant plane, in the spirit of the
+// mapbox earcut path tinyobj can be built with. Falls back to a fan if no ear can be found
+// (self-intersecting input), so every face still produces count - 2 triangles.
+static void triangulateEarClip(const unsigned int* corners, const vec3* points, size_t count, const vec3& normal,
+    std::vector<unsigned int>& indices)
+{
+    // Drop the axis the normal points along and keep the winding counter clockwise.
+    float ax = std::fabs(normal.x), ay = std::fabs(normal.y), az = std::fabs(normal.z);
+
+    std::vector<vec2> projected(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (az >= ax && az >= ay) projected[i] = normal.z >= 0 ? vec2(points[i].x, points[i].y) : vec2(points[i].y, points[i].x);
+        else if (ax >= ay)        projected[i] = normal.x >= 0 ? vec2(points[i].y, points[i].z) : vec2(points[i].z, points[i].y);
+        else                      projected[i] = normal.y >= 0 ? vec2(points[i].z, points[i].x) : vec2(points[i].x, points[i].z);
+    }
+
+    std::vector<size_t> remaining(count);
+    for (size_t i = 0; i < count; ++i) remaining[i] = i;
+
+    size_t guard = 0;
+    size_t i = 0;
+
+    while (remaining.size() > 3 && guard < remaining.size())
+    {
+        size_t n = remaining.size();
+        size_t prev = remaining[(i + n - 1) % n];
+        size_t curr = remaining[i % n];
+        size_t next = remaining[(i + 1) % n];
+
+        bool isEar = cross2(projected[prev], projected[curr], projected[next]) > 0.0f;
+
+        for (size_t k = 0; isEar && k < n; ++k)
+        {
+            size_t other = remaining[k];
+            if (other == prev || other == curr || other == next) continue;
+
+            isEar = !pointInTriangle(projected[other], projected[prev], projected[curr], projected[next]);
+        }
+
+        if (isEar)
+        {
+            indices.push_back(corners[prev]);
+            indices.push_back(corners[curr]);
+            indices.push_back(corners[next]);
+
+            remaining.erase(remaining.begin() + (i % n));
+            guard = 0;
+        }
+        else
+        {
+            ++i;
+            ++guard;
+        }
+
+        i %= remaining.size();
+    }
+
+    std::vector<unsigned int> rest(remaining.size());
+    for (size_t k = 0; k < remaining.size(); ++k) rest[k] = corners[remaining[k]];
+
+    triangulateFan(rest.data(), rest.size(), indices);
+}
+#pragma endregion
+
+// Appends the triangles of one polygonal face and returns how many were written.
+// corners are the final vertex indices of the face and points their positions.
+static size_t triangulateFace(const unsigned int* corners, const vec3* points, size_t count, std::vector<unsigned int>& indices,
+    TriangulationMode mode = triangulationMode)
+{
+    size_t before = indices.size();
+
+    if (count < 3)
+    {
+        return 0;
+    }
+
+    if (count == 3 || mode == TriangulationMode::Fan)
+    {
+        triangulateFan(corners, count, indices);
+        return (indices.size() - before) / 3;
+    }
+
+    vec3 normal = polygonNormal(points, count);
+
+    if (mode == TriangulationMode::Auto && isConvexPolygon(points, count, normal))
+    {
+        triangulateFan(corners, count, indices);
+    }
+    else
+    {
+        triangulateEarClip(corners, points, count, normal, indices);
+    }
+
+    return (indices.size() - before) / 3;
+}
+
+static const char* triangulationModeName(TriangulationMode mode = triangulationMode)
+{
+    switch (mode)
+    {
+        case TriangulationMode::Fan: return "fan";
+        case TriangulationMode::EarClip: return "ear clip";
+        default: return "auto";
+    }
+}
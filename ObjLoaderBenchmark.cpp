@@ -1,27 +1,143 @@
-#pragma once
-
 const bool deduplicateVertices = false;
 
+// Fan: fan every face, EarClip: ear clip every n-gon, Auto: fan convex faces and ear clip concave ones.
+enum class TriangulationMode { Fan, EarClip, Auto };
+const TriangulationMode triangulationMode = TriangulationMode::Auto;
+
+// Store loaded indices as 16 bit whenever the mesh has at most 65536 vertices.
+const bool compactIndexBuffers = true;
+
+// Instruction set of NewFast's parse kernels. Auto probes the CPU; forcing one applies it to every
+// NewFast loader, falling back to the widest supported set when the CPU lacks it.
+enum class KernelIsa { Auto, Scalar, SSE2, AVX2, AVX512 };
+const KernelIsa kernelIsa = KernelIsa::Auto;
+
+// Count cycles, instructions and cache misses around every load where perf_event_open is available.
+const bool collectPerfCounters = true;
+
+// Count heap allocations through a replaced global operator new; RSS growth is reported either way.
+const bool profileAllocations = true;
+
+// Which objs the scan picks up below the obj folder. Patterns are ';' separated globs ('*', '**', '?')
+// matched against the path below the folder, or against the file name when they hold no '/'; an empty
+// include list takes every obj. Size limits are in bytes, 0 for none.
+const bool scanRecursively = true;
+const char* scanIncludePatterns = "";
+const char* scanExcludePatterns = "";
+const unsigned long long scanMinFileBytes = 0;
+const unsigned long long scanMaxFileBytes = 0;
+
+// Hand files to the loaders largest first, so parallel batch loads do not end on one big file.
+const bool scanLargestFirst = true;
+
+// PLY and STL loaders read copies of the scanned objs written here before the loaders run.
+const char* interchangeFolderPath = "Interchange";
+
+// The n-gon obj for the triangulation checks is generated into this folder and loaded with the scanned objs.
+const char* syntheticFolderPath = "Synthetic";
+
+const unsigned int syntheticGridResolution = 1024;
+const unsigned int syntheticNgonCount = 3600;
+const unsigned int repeatedLoadThreads = 4;
+const unsigned int repeatedLoadRepeats = 8;
+const unsigned int syntheticMaterialCount = 20000;
+const unsigned int materialParseRepeats = 8;
+const unsigned int kernelComparisonRepeats = 4;
+const unsigned int batchLoadThreads = 4;
+
+#include "Utils/allocationHook.h"
 #include "Utils/objFileScanner.h"
 #include "Utils/implementationsRunner.h"
+#include "Utils/repeatedLoadRunner.h"
+#include "Utils/compressedInputRunner.h"
+#include "Utils/exportRunner.h"
+#include "Utils/materialRunner.h"
+#include "Utils/kernelRunner.h"
+#include "Utils/scanRunner.h"
 #include "Utils/resultsDisplayer.h"
 
+// The first command line argument overrides this.
 const char* objFolderPath = "Objs";
+const char* exportFolderPath = "Exported";
 
-int main()
+// Written when built with OBJ_WITH_TRACE; open it in Perfetto or chrome://tracing.
+const char* traceFilePath = "trace.json";
+
+int main(int argc, char** argv)
 {
+    TRACE_THREAD_NAME("main");
+
     writeNewLine("Welcome to my tiny benchmark.");
     writeNewLine("Scanning obj files.");
 
-    std::vector<std::string> paths = scanFolderForObjFiles(objFolderPath);
+    std::string folderPath = argc > 1 ? argv[1] : objFolderPath;
+
+    std::vector<std::string> paths = scanFolderForObjFiles(folderPath);
+
+    std::string ngonPath = writeSyntheticNgonObj(syntheticFolderPath, syntheticNgonCount);
+    if (!ngonPath.empty()) paths.push_back(ngonPath);
+
+    writeNewLine("Converting obj files for the PLY and STL loaders.");
+
+    writeInterchangeFiles(&newFastImplementation, paths);
 
     writeNewLine("Running implementations.");
 
     std::vector<Results> results = runImplementations(paths);
 
+    writeNewLine("Running post-processing on synthetic meshes.");
+
+    std::vector<Results> syntheticResults = runSyntheticPostProcessing(syntheticGridResolution);
+
+    writeNewLine("Running repeated loads.");
+
+    std::vector<Results> repeatedResults = runRepeatedLoads(&newFastImplementation, paths, repeatedLoadThreads, repeatedLoadRepeats);
+
+    writeNewLine("Running compressed inputs.");
+
+    std::vector<std::string> compressedPaths = scanFolderForObjFiles(folderPath, true);
+
+    std::vector<Results> compressedResults = runCompressedLoads(&newFastImplementation, compressedPaths);
+
+    writeNewLine("Running exports.");
+
+    std::vector<Results> exportResults = runExports(&newFastImplementation, paths, exportFolderPath);
+
+    writeNewLine("Running material libraries.");
+
+    std::vector<Results> materialResults = runMaterialLoads(paths, syntheticMaterialCount, materialParseRepeats);
+
+    writeNewLine("Comparing parse kernels.");
+
+    std::vector<Results> kernelResults = runKernelComparison(paths, kernelComparisonRepeats);
+
+    writeNewLine("Scanning folders.");
+
+    std::vector<Results> scanResults = runFolderScans(&newFastImplementation, folderPath, batchLoadThreads);
+
+    TRACE_WRITE(traceFilePath);
+
     writeNewLine("Finished.\n\n");
 
     showResults(results);
 
+    showMemoryResults(results);
+
+    showSyntheticResults(syntheticResults);
+
+    showRepeatedLoadResults(repeatedResults);
+
+    showCompressedInputResults(compressedResults);
+
+    showExportResults(exportResults);
+
+    showMaterialResults(materialResults);
+
+    showKernelResults(kernelResults);
+
+    showScanResults(scanResults);
+
+#ifdef _WIN32
     system("pause");
+#endif
 };
\ No newline at end of file
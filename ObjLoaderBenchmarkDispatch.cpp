@@ -0,0 +1,58 @@
+// Runs the widest ObjLoaderBenchmark variant this CPU supports. The CMake build compiles the whole
+// benchmark once per instruction set and places the variants next to this launcher, which replaces
+// itself with the chosen one so the benchmark sees the same arguments and working directory.
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+struct Variant
+{
+    const char* suffix;
+    bool supported;
+};
+
+int main(int argc, char** argv)
+{
+    __builtin_cpu_init();
+
+    // Every flag a variant is compiled with has to be checked here, the compiler may use any of them.
+    bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi")
+        && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("lzcnt") && __builtin_cpu_supports("f16c");
+    bool avx512 = avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+
+    const Variant variants[] = {
+        { "_avx512", avx512 },
+        { "_avx2", avx2 },
+        { "_sse42", __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt") },
+        { "", true }
+    };
+
+    std::error_code error;
+    std::filesystem::path self = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (error) self = std::filesystem::absolute(argv[0], error);
+
+    for (const Variant& variant : variants)
+    {
+        if (!variant.supported) continue;
+
+        std::filesystem::path candidate = self.parent_path() / (std::string("ObjLoaderBenchmark") + variant.suffix);
+        if (!std::filesystem::exists(candidate, error)) continue;
+
+        std::cout << "Running " << candidate.filename().string() << "\n" << std::flush;
+
+        std::string program = candidate.string();
+        std::vector<char*> arguments{ program.data() };
+        arguments.insert(arguments.end(), argv + 1, argv + argc);
+        arguments.push_back(nullptr);
+
+        execv(program.c_str(), arguments.data());
+        std::cout << "Failed to start " << program << "\n";
+    }
+
+    std::cout << "No ObjLoaderBenchmark build found next to " << self.string() << "\n";
+    return 1;
+}
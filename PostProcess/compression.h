@@ -0,0 +1,458 @@
+#pragma once
+
+#include "post_process_template.h"
+
+#include <cstdint>
+#include <cstring>
+
+#pragma region Helper functions
+static inline void writeVarint(std::vector<uint8_t>& out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+
+    out.push_back((uint8_t)value);
+}
+
+static inline uint32_t readVarint(const uint8_t*& data)
+{
+    uint32_t value = 0;
+    unsigned shift = 0;
+
+    while (*data & 0x80)
+    {
+        value |= (uint32_t)(*data++ & 0x7f) << shift;
+        shift += 7;
+    }
+
+    return value | ((uint32_t)*data++ << shift);
+}
+
+static inline uint32_t zigzag32(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag32(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Zigzagged byte deltas of 16 bytes; data[-1] is the byte before the group. Returns the largest result.
+static inline uint8_t encodeByteDeltas16(const uint8_t* data, uint8_t* zigzag)
+{
+#ifdef OBJ_SSE2
+    __m128i current = _mm_loadu_si128((const __m128i*)data);
+    __m128i previous = _mm_loadu_si128((const __m128i*)(data - 1));
+    __m128i delta = _mm_sub_epi8(current, previous);
+    __m128i z = _mm_xor_si128(_mm_add_epi8(delta, delta), _mm_cmpgt_epi8(_mm_setzero_si128(), delta));
+    _mm_storeu_si128((__m128i*)zigzag, z);
+
+    __m128i m = _mm_max_epu8(z, _mm_srli_si128(z, 8));
+    m = _mm_max_epu8(m, _mm_srli_si128(m, 4));
+    m = _mm_max_epu8(m, _mm_srli_si128(m, 2));
+    m = _mm_max_epu8(m, _mm_srli_si128(m, 1));
+    return (uint8_t)_mm_cvtsi128_si32(m);
+#else
+    uint8_t largest = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int8_t delta = (int8_t)(data[i] - data[i - 1]);
+        zigzag[i] = (uint8_t)((delta << 1) ^ (delta >> 7));
+        largest = std::max(largest, zigzag[i]);
+    }
+
+    return largest;
+#endif
+}
+
+// Inverse of encodeByteDeltas16: undo the zigzag and prefix sum the deltas on top of carry, in place.
+static inline void decodeByteDeltas16(uint8_t* data, uint8_t carry)
+{
+#ifdef OBJ_SSE2
+    __m128i z = _mm_loadu_si128((const __m128i*)data);
+    __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(z, _mm_set1_epi8(1)));
+    __m128i v = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(z, 1), _mm_set1_epi8(0x7f)), sign);
+
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+    _mm_storeu_si128((__m128i*)data, _mm_add_epi8(v, _mm_set1_epi8((char)carry)));
+#else
+    for (int i = 0; i < 16; ++i)
+    {
+        carry = (uint8_t)(carry + ((data[i] >> 1) ^ (uint8_t)-(data[i] & 1)));
+        data[i] = carry;
+    }
+#endif
+}
+#pragma endregion
+
+#pragma region Index codec
+// Triangles are written one code byte each, plus LEB128 varints of zigzagged vertex deltas:
+//   0x00        no shared edge, three vertex deltas follow
+//   0x10 | e    shares cached edge e, the third vertex is the next unseen vertex, nothing follows
+//   0x20 | e    shares cached edge e, one delta for the third vertex follows
+// Edges of recent triangles sit in a 16 entry FIFO. A triangle may come back rotated so that its
+// shared edge is first, which keeps its winding and therefore renders identically.
+const size_t indexEdgeCacheSize = 16;
+
+struct IndexEdgeCache
+{
+    uint32_t edges[indexEdgeCacheSize][2] = {};
+    size_t head = 0;
+
+    void push(uint32_t a, uint32_t b)
+    {
+        edges[head][0] = a;
+        edges[head][1] = b;
+        head = (head + 1) % indexEdgeCacheSize;
+    }
+
+    // An adjacent triangle walks the shared edge the other way, so edges are stored reversed.
+    void pushTriangle(uint32_t a, uint32_t b, uint32_t c)
+    {
+        push(b, a);
+        push(c, b);
+        push(a, c);
+    }
+
+    int find(uint32_t a, uint32_t b) const
+    {
+        for (size_t i = 0; i < indexEdgeCacheSize; ++i)
+        {
+            if (edges[i][0] == a && edges[i][1] == b) return (int)i;
+        }
+
+        return -1;
+    }
+};
+
+static std::vector<uint8_t> encodeIndexBuffer(const unsigned int* indices, size_t indexCount)
+{
+    std::vector<uint8_t> codes, deltas;
+    codes.reserve(indexCount / 3);
+    deltas.reserve(indexCount);
+
+    IndexEdgeCache cache;
+    uint32_t next = 0;
+    uint32_t last = 0;
+
+    for (size_t t = 0; t + 2 < indexCount; t += 3)
+    {
+        uint32_t tri[3] = { indices[t], indices[t + 1], indices[t + 2] };
+        int edge = -1;
+        int rotation = 0;
+
+        for (; rotation < 3 && edge < 0; ++rotation)
+        {
+            edge = cache.find(tri[rotation], tri[(rotation + 1) % 3]);
+        }
+
+        if (edge >= 0)
+        {
+            --rotation;
+            uint32_t a = tri[rotation], b = tri[(rotation + 1) % 3], c = tri[(rotation + 2) % 3];
+
+            if (c == next)
+            {
+                codes.push_back((uint8_t)(0x10 | edge));
+            }
+            else
+            {
+                codes.push_back((uint8_t)(0x20 | edge));
+                writeVarint(deltas, zigzag32((int32_t)(c - last)));
+            }
+
+            tri[0] = a; tri[1] = b; tri[2] = c;
+            last = c;
+        }
+        else
+        {
+            codes.push_back(0);
+
+            for (uint32_t v : tri)
+            {
+                writeVarint(deltas, zigzag32((int32_t)(v - last)));
+                last = v;
+            }
+        }
+
+        next = std::max(next, std::max(tri[0], std::max(tri[1], tri[2])) + 1);
+        cache.pushTriangle(tri[0], tri[1], tri[2]);
+    }
+
+    // Layout: triangle count, code bytes, delta bytes.
+    std::vector<uint8_t> out;
+    out.reserve(codes.size() + deltas.size() + 8);
+    writeVarint(out, (uint32_t)codes.size());
+    out.insert(out.end(), codes.begin(), codes.end());
+    out.insert(out.end(), deltas.begin(), deltas.end());
+    return out;
+}
+
+static std::vector<unsigned int> decodeIndexBuffer(const std::vector<uint8_t>& encoded)
+{
+    const uint8_t* data = encoded.data();
+    size_t triangleCount = readVarint(data);
+    const uint8_t* codes = data;
+    const uint8_t* deltas = data + triangleCount;
+
+    std::vector<unsigned int> indices(triangleCount * 3);
+
+    IndexEdgeCache cache;
+    uint32_t next = 0;
+    uint32_t last = 0;
+
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        uint8_t code = codes[t];
+        uint32_t a, b, c;
+
+        if (code == 0)
+        {
+            a = last + unzigzag32(readVarint(deltas));
+            b = a + unzigzag32(readVarint(deltas));
+            c = b + unzigzag32(readVarint(deltas));
+        }
+        else
+        {
+            const uint32_t* edge = cache.edges[code & 0x0f];
+            a = edge[0];
+            b = edge[1];
+            c = (code & 0x10) ? next : last + unzigzag32(readVarint(deltas));
+        }
+
+        indices[t * 3] = a;
+        indices[t * 3 + 1] = b;
+        indices[t * 3 + 2] = c;
+
+        last = c;
+        next = std::max(next, std::max(a, std::max(b, c)) + 1);
+        cache.pushTriangle(a, b, c);
+    }
+
+    return indices;
+}
+#pragma endregion
+
+#pragma region Vertex codec
+// Vertices are coded in blocks of up to 256. Inside a block every byte position of the vertex is
+// gathered into its own plane, delta coded against the previous vertex and zigzagged, so slowly
+// changing bytes (sign, exponent, high mantissa) turn into runs of small values. Each group of 16
+// plane bytes is then stored with 0, 2, 4 or 8 bits per byte, chosen by a 2 bit header.
+const size_t vertexBlockSize = 256;
+
+static std::vector<uint8_t> encodeVertexBuffer(const void* vertices, size_t vertexCount, size_t stride)
+{
+    const uint8_t* src = (const uint8_t*)vertices;
+    std::vector<uint8_t> out;
+    out.reserve(vertexCount * stride / 2);
+
+    std::vector<uint8_t> previous(stride, 0);
+    uint8_t plane[1 + vertexBlockSize];
+    uint8_t zigzag[vertexBlockSize];
+    uint8_t widths[vertexBlockSize / 16];
+
+    for (size_t base = 0; base < vertexCount; base += vertexBlockSize)
+    {
+        size_t count = std::min(vertexBlockSize, vertexCount - base);
+        size_t groups = (count + 15) / 16;
+
+        for (size_t k = 0; k < stride; ++k)
+        {
+            plane[0] = previous[k];
+            for (size_t i = 0; i < count; ++i) plane[1 + i] = src[(base + i) * stride + k];
+            for (size_t i = count; i < groups * 16; ++i) plane[1 + i] = plane[count]; // zero deltas
+
+            for (size_t g = 0; g < groups; ++g)
+            {
+                uint8_t largest = encodeByteDeltas16(plane + 1 + g * 16, zigzag + g * 16);
+                widths[g] = largest == 0 ? 0 : largest < 4 ? 1 : largest < 16 ? 2 : 3;
+            }
+
+            for (size_t g = 0; g < groups; g += 4)
+            {
+                uint8_t header = 0;
+                for (size_t j = 0; j < 4 && g + j < groups; ++j) header |= widths[g + j] << (j * 2);
+                out.push_back(header);
+            }
+
+            for (size_t g = 0; g < groups; ++g)
+            {
+                const uint8_t* z = zigzag + g * 16;
+
+                switch (widths[g])
+                {
+                    case 1:
+                        for (size_t i = 0; i < 16; i += 4)
+                            out.push_back((uint8_t)(z[i] | (z[i + 1] << 2) | (z[i + 2] << 4) | (z[i + 3] << 6)));
+                        break;
+                    case 2:
+                        for (size_t i = 0; i < 16; i += 2)
+                            out.push_back((uint8_t)(z[i] | (z[i + 1] << 4)));
+                        break;
+                    case 3:
+                        out.insert(out.end(), z, z + 16);
+                        break;
+                }
+            }
+
+            previous[k] = plane[count];
+        }
+    }
+
+    return out;
+}
+
+static bool decodeVertexBuffer(const std::vector<uint8_t>& encoded, void* vertices, size_t vertexCount, size_t stride)
+{
+    uint8_t* dst = (uint8_t*)vertices;
+    const uint8_t* data = encoded.data();
+    const uint8_t* end = data + encoded.size();
+
+    std::vector<uint8_t> previous(stride, 0);
+    uint8_t plane[vertexBlockSize];
+
+    for (size_t base = 0; base < vertexCount; base += vertexBlockSize)
+    {
+        size_t count = std::min(vertexBlockSize, vertexCount - base);
+        size_t groups = (count + 15) / 16;
+
+        for (size_t k = 0; k < stride; ++k)
+        {
+            const uint8_t* headers = data;
+            data += (groups + 3) / 4;
+            if (data > end) return false;
+
+            uint8_t carry = previous[k];
+
+            for (size_t g = 0; g < groups; ++g)
+            {
+                uint8_t* z = plane + g * 16;
+                unsigned width = (headers[g / 4] >> ((g % 4) * 2)) & 3;
+                size_t payload = width == 0 ? 0 : (size_t)4 << (width - 1);
+                if (data + payload > end) return false;
+
+                switch (width)
+                {
+                    case 0:
+                        std::memset(z, 0, 16);
+                        break;
+                    case 1:
+                        for (size_t i = 0; i < 16; i += 4, ++data)
+                        {
+                            z[i] = *data & 3; z[i + 1] = (*data >> 2) & 3; z[i + 2] = (*data >> 4) & 3; z[i + 3] = *data >> 6;
+                        }
+                        break;
+                    case 2:
+                        for (size_t i = 0; i < 16; i += 2, ++data)
+                        {
+                            z[i] = *data & 15; z[i + 1] = *data >> 4;
+                        }
+                        break;
+                    case 3:
+                        std::memcpy(z, data, 16);
+                        data += 16;
+                        break;
+                }
+
+                decodeByteDeltas16(z, carry);
+                carry = z[15];
+            }
+
+            for (size_t i = 0; i < count; ++i) dst[(base + i) * stride + k] = plane[i];
+            previous[k] = plane[count - 1];
+        }
+    }
+
+    return true;
+}
+#pragma endregion
+
+struct CompressedMesh
+{
+    std::vector<uint8_t> indexData;
+    std::vector<uint8_t> vertexData;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+};
+
+// Compresses each mesh with the codecs above, decodes it again to check the round trip, and reports
+// the ratio and encode/decode throughput. Runs best after the vertex cache optimizer, whose first-use
+// vertex order is what makes both the edge cache and the vertex deltas effective.
+class MeshCompressor : public PostProcessTemplate
+{
+private:
+    double encodeSeconds = 0.0;
+    double decodeSeconds = 0.0;
+    bool roundTripOk = true;
+
+    static bool sameTriangle(const unsigned int* a, const unsigned int* b)
+    {
+        for (int r = 0; r < 3; ++r)
+        {
+            if (a[0] == b[r] && a[1] == b[(r + 1) % 3] && a[2] == b[(r + 2) % 3]) return true;
+        }
+
+        return false;
+    }
+
+public:
+    CompressedMesh lastCompressed;
+
+    const char* Name() const override
+    {
+        return "mesh compression";
+    }
+
+    void measureAfter(const Mesh& mesh, StageResult& result) override
+    {
+        double rawBytes = (double)(mesh.vertices.size() * sizeof(Vertex) + mesh.indexCount() * sizeof(unsigned int));
+        double packedBytes = (double)(lastCompressed.vertexData.size() + lastCompressed.indexData.size());
+        double triangles = (double)(mesh.indexCount() / 3);
+
+        result.metrics.push_back({ "compression ratio", packedBytes > 0 ? rawBytes / packedBytes : 0.0 });
+        result.metrics.push_back({ "index bits per triangle", triangles > 0 ? lastCompressed.indexData.size() * 8.0 / triangles : 0.0 });
+        result.metrics.push_back({ "vertex bytes per vertex", mesh.vertices.empty() ? 0.0 : (double)lastCompressed.vertexData.size() / mesh.vertices.size() });
+        result.metrics.push_back({ "encode GB/s", encodeSeconds > 0 ? rawBytes / encodeSeconds / 1e9 : 0.0 });
+        result.metrics.push_back({ "decode GB/s", decodeSeconds > 0 ? rawBytes / decodeSeconds / 1e9 : 0.0 });
+        result.metrics.push_back({ "round trip ok", roundTripOk ? 1.0 : 0.0 });
+    }
+
+    size_t processImplementation(Mesh& mesh) override
+    {
+        const std::vector<unsigned int>& meshIndices = mesh.indices();
+        size_t triangleIndices = meshIndices.size() - meshIndices.size() % 3;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        lastCompressed.indexData = encodeIndexBuffer(meshIndices.data(), triangleIndices);
+        lastCompressed.vertexData = encodeVertexBuffer(mesh.vertices.data(), mesh.vertices.size(), sizeof(Vertex));
+        lastCompressed.vertexCount = mesh.vertices.size();
+        lastCompressed.indexCount = triangleIndices;
+        auto encoded = std::chrono::high_resolution_clock::now();
+
+        std::vector<unsigned int> indices = decodeIndexBuffer(lastCompressed.indexData);
+        std::vector<Vertex> vertices(mesh.vertices.size());
+        bool decodedVertices = decodeVertexBuffer(lastCompressed.vertexData, vertices.data(), vertices.size(), sizeof(Vertex));
+        auto decoded = std::chrono::high_resolution_clock::now();
+
+        encodeSeconds = std::chrono::duration<double>(encoded - start).count();
+        decodeSeconds = std::chrono::duration<double>(decoded - encoded).count();
+
+        roundTripOk = decodedVertices && indices.size() == triangleIndices
+            && std::memcmp(vertices.data(), mesh.vertices.data(), vertices.size() * sizeof(Vertex)) == 0;
+
+        for (size_t t = 0; roundTripOk && t < triangleIndices; t += 3)
+        {
+            roundTripOk = sameTriangle(&indices[t], &meshIndices[t]);
+        }
+
+        return mesh.vertices.size() * sizeof(Vertex) + meshIndices.size() * sizeof(unsigned int);
+    }
+};
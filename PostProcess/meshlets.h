@@ -0,0 +1,250 @@
+#pragma once
+
+#include "post_process_template.h"
+#include "../Utils/parallelFor.h"
+
+struct Meshlet
+{
+    unsigned int vertexOffset;
+    unsigned int triangleOffset;
+    unsigned int vertexCount;
+    unsigned int triangleCount;
+
+    // Bounding sphere
+    vec3 center;
+    float radius;
+
+    // Normal cone, culled when dot(normalize(coneApex - camera), coneAxis) >= coneCutoff
+    vec3 coneApex;
+    vec3 coneAxis;
+    float coneCutoff;
+};
+
+struct MeshletData
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<unsigned int> vertices;     // global vertex indices, referenced by Meshlet::vertexOffset
+    std::vector<unsigned char> triangles;   // local indices, 3 per triangle, referenced by Meshlet::triangleOffset
+};
+
+#pragma region Helper functions
+static void computeMeshletBounds(const Mesh& mesh, const MeshletData& data, Meshlet& meshlet)
+{
+    const unsigned int* localVertices = &data.vertices[meshlet.vertexOffset];
+    const unsigned char* localTriangles = &data.triangles[meshlet.triangleOffset];
+
+    // Sphere around the AABB center, tight enough for culling and cheap to compute.
+    vec3 minP(std::numeric_limits<float>::max());
+    vec3 maxP(-std::numeric_limits<float>::max());
+
+    for (unsigned int v = 0; v < meshlet.vertexCount; ++v)
+    {
+        const vec3& p = mesh.vertices[localVertices[v]].pos;
+        minP = vec3(std::min(minP.x, p.x), std::min(minP.y, p.y), std::min(minP.z, p.z));
+        maxP = vec3(std::max(maxP.x, p.x), std::max(maxP.y, p.y), std::max(maxP.z, p.z));
+    }
+
+    meshlet.center = (minP + maxP) * 0.5f;
+    meshlet.radius = 0.0f;
+
+    for (unsigned int v = 0; v < meshlet.vertexCount; ++v)
+    {
+        meshlet.radius = std::max(meshlet.radius, (mesh.vertices[localVertices[v]].pos - meshlet.center).length());
+    }
+
+    // Cone axis is the average of the unit face normals, the cutoff comes from the widest deviation.
+    std::vector<vec3> faceNormals;
+    faceNormals.reserve(meshlet.triangleCount);
+    vec3 axis(0.0f);
+
+    for (unsigned int t = 0; t < meshlet.triangleCount; ++t)
+    {
+        const vec3& a = mesh.vertices[localVertices[localTriangles[t * 3 + 0]]].pos;
+        const vec3& b = mesh.vertices[localVertices[localTriangles[t * 3 + 1]]].pos;
+        const vec3& c = mesh.vertices[localVertices[localTriangles[t * 3 + 2]]].pos;
+
+        vec3 n = vec3::cross(b - a, c - a).normalized();
+        faceNormals.push_back(n);
+        axis += n;
+    }
+
+    axis = axis.normalized();
+
+    float minDot = 1.0f;
+    for (const vec3& n : faceNormals)
+    {
+        minDot = std::min(minDot, vec3::dot(n, axis));
+    }
+
+    meshlet.coneAxis = axis;
+    meshlet.coneApex = meshlet.center;
+
+    if (minDot <= 0.1f || axis.length() == 0.0f)
+    {
+        // Normals spread over more than a hemisphere, the cone can never cull.
+        meshlet.coneCutoff = 1.0f;
+        return;
+    }
+
+    // Move the apex back along the axis until every triangle plane lies in front of it.
+    float maxT = 0.0f;
+    for (unsigned int t = 0; t < meshlet.triangleCount; ++t)
+    {
+        const vec3& a = mesh.vertices[localVertices[localTriangles[t * 3 + 0]]].pos;
+        float denominator = vec3::dot(faceNormals[t], axis);
+        float distance = vec3::dot(meshlet.center - a, faceNormals[t]);
+
+        if (denominator > 0.0f)
+        {
+            maxT = std::max(maxT, distance / denominator);
+        }
+    }
+
+    meshlet.coneApex = meshlet.center - axis * maxT;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+#pragma endregion
+
+class MeshletBuilder : public PostProcessTemplate
+{
+private:
+    size_t maxVertices;
+    size_t maxTriangles;
+
+    static const size_t trianglesPerChunk = 1 << 15;
+
+    // Greedily fills meshlets in index buffer order, so it benefits from a cache optimized mesh.
+    // localIndex maps global -> local vertex slot, -1 when the vertex is not in the current meshlet;
+    // it must come in all -1 and is left that way, so one buffer serves every chunk of a thread.
+    void buildRange(const unsigned int* indices, size_t firstTriangle, size_t lastTriangle, std::vector<short>& localIndex, MeshletData& out) const
+    {
+        Meshlet current{};
+        current.vertexOffset = (unsigned int)out.vertices.size();
+        current.triangleOffset = (unsigned int)out.triangles.size();
+
+        auto flush = [&]()
+        {
+            if (current.triangleCount == 0) return;
+
+            for (size_t v = current.vertexOffset; v < out.vertices.size(); ++v)
+            {
+                localIndex[out.vertices[v]] = -1;
+            }
+
+            out.meshlets.push_back(current);
+            current = Meshlet{};
+            current.vertexOffset = (unsigned int)out.vertices.size();
+            current.triangleOffset = (unsigned int)out.triangles.size();
+        };
+
+        for (size_t t = firstTriangle; t < lastTriangle; ++t)
+        {
+            const unsigned int* tri = &indices[t * 3];
+
+            size_t newVertices = (localIndex[tri[0]] < 0) + (localIndex[tri[1]] < 0) + (localIndex[tri[2]] < 0);
+
+            if (current.vertexCount + newVertices > maxVertices || current.triangleCount + 1 > maxTriangles)
+            {
+                flush();
+            }
+
+            for (int k = 0; k < 3; ++k)
+            {
+                if (localIndex[tri[k]] < 0)
+                {
+                    localIndex[tri[k]] = (short)current.vertexCount;
+                    out.vertices.push_back(tri[k]);
+                    current.vertexCount++;
+                }
+
+                out.triangles.push_back((unsigned char)localIndex[tri[k]]);
+            }
+
+            current.triangleCount++;
+        }
+
+        flush();
+    }
+
+public:
+    // Output of the most recent run, kept for the culling pipeline to pick up.
+    MeshletData lastMeshlets;
+
+    MeshletBuilder(size_t maxVertices = 64, size_t maxTriangles = 124)
+        : maxVertices(std::min<size_t>(maxVertices, 256)), maxTriangles(std::max<size_t>(maxTriangles, 1))
+    {}
+
+    const char* Name() const override
+    {
+        return "meshlet generation";
+    }
+
+    // Large meshes are cut into fixed size triangle chunks that are clustered independently,
+    // so the output does not depend on the number of threads.
+    MeshletData build(Mesh& mesh) const
+    {
+        const std::vector<unsigned int>& indices = mesh.indices();
+        size_t triangleCount = indices.size() / 3;
+        size_t chunkCount = std::max<size_t>(1, (triangleCount + trianglesPerChunk - 1) / trianglesPerChunk);
+
+        std::vector<MeshletData> chunks(chunkCount);
+
+        parallelFor(chunkCount, 1, [&](size_t begin, size_t end)
+        {
+            std::vector<short> localIndex(mesh.vertices.size(), -1);
+
+            for (size_t c = begin; c < end; ++c)
+            {
+                size_t first = c * trianglesPerChunk;
+                size_t last = std::min(triangleCount, first + trianglesPerChunk);
+                buildRange(indices.data(), first, last, localIndex, chunks[c]);
+            }
+        });
+
+        MeshletData data;
+
+        for (MeshletData& chunk : chunks)
+        {
+            unsigned int vertexBase = (unsigned int)data.vertices.size();
+            unsigned int triangleBase = (unsigned int)data.triangles.size();
+
+            for (Meshlet m : chunk.meshlets)
+            {
+                m.vertexOffset += vertexBase;
+                m.triangleOffset += triangleBase;
+                data.meshlets.push_back(m);
+            }
+
+            data.vertices.insert(data.vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+            data.triangles.insert(data.triangles.end(), chunk.triangles.begin(), chunk.triangles.end());
+        }
+
+        parallelFor(data.meshlets.size(), 256, [&](size_t begin, size_t end)
+        {
+            for (size_t m = begin; m < end; ++m)
+            {
+                computeMeshletBounds(mesh, data, data.meshlets[m]);
+            }
+        });
+
+        return data;
+    }
+
+    void measureAfter(const Mesh& mesh, StageResult& result) override
+    {
+        size_t meshletCount = lastMeshlets.meshlets.size();
+        double averageVertices = meshletCount ? (double)lastMeshlets.vertices.size() / meshletCount : 0.0;
+        double averageTriangles = meshletCount ? (double)lastMeshlets.triangles.size() / 3 / meshletCount : 0.0;
+
+        result.metrics.push_back({ "meshlets", (double)meshletCount });
+        result.metrics.push_back({ "vertices per meshlet", averageVertices });
+        result.metrics.push_back({ "triangles per meshlet", averageTriangles });
+    }
+
+    size_t processImplementation(Mesh& mesh) override
+    {
+        lastMeshlets = build(mesh);
+
+        return mesh.indexBytes() + mesh.vertices.size() * sizeof(Vertex);
+    }
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "post_process_template.h"
+#include "../Utils/parallelFor.h"
+
+#include <cstring>
+
+enum class NormalWeighting
+{
+    Area,
+    Angle
+};
+
+#pragma region Helper functions
+struct PositionKey
+{
+    unsigned int x, y, z;
+
+    bool operator==(const PositionKey& o) const
+    {
+        return x == o.x && y == o.y && z == o.z;
+    }
+};
+
+struct PositionKeyHash
+{
+    size_t operator()(const PositionKey& k) const
+    {
+        return ((size_t)k.x * 73856093u) ^ ((size_t)k.y * 19349663u) ^ ((size_t)k.z * 83492791u);
+    }
+};
+
+static inline PositionKey makePositionKey(const vec3& p)
+{
+    // Fold -0 into +0 so mirrored seams still weld.
+    float coords[3] = { p.x + 0.0f, p.y + 0.0f, p.z + 0.0f };
+    PositionKey key;
+    std::memcpy(&key, coords, sizeof(key));
+    return key;
+}
+
+static inline float cornerAngle(const vec3& corner, const vec3& a, const vec3& b)
+{
+    vec3 e0 = (a - corner).normalized();
+    vec3 e1 = (b - corner).normalized();
+    float d = std::max(-1.0f, std::min(1.0f, vec3::dot(e0, e1)));
+    return std::acos(d);
+}
+
+// Maps every vertex to a welded position id, so split vertices (uv seams, no dedup) still share normals.
+static size_t weldPositions(const std::vector<Vertex>& vertices, std::vector<unsigned int>& positionIds)
+{
+    std::unordered_map<PositionKey, unsigned int, PositionKeyHash> ids;
+    ids.reserve(vertices.size());
+    positionIds.resize(vertices.size());
+
+    for (size_t v = 0; v < vertices.size(); ++v)
+    {
+        auto it = ids.emplace(makePositionKey(vertices[v].pos), (unsigned int)ids.size()).first;
+        positionIds[v] = it->second;
+    }
+
+    return ids.size();
+}
+#pragma endregion
+
+// Fills in smooth normals for vertices that came without one (OBJ files without 'vn').
+// Corners are welded by position and smoothing group; group 0 ("s off") keeps faces flat.
+// Face normals are computed in parallel per triangle and summed with a gather per welded
+// position, so no thread ever writes to another thread's output and no atomics are needed.
+class NormalGenerator : public PostProcessTemplate
+{
+private:
+    NormalWeighting weighting;
+    size_t generatedCount = 0;
+
+    vec3 cornerNormal(const Mesh& mesh, size_t triangle, int corner) const
+    {
+        const vec3& a = mesh.vertices[mesh.index(triangle * 3 + 0)].pos;
+        const vec3& b = mesh.vertices[mesh.index(triangle * 3 + 1)].pos;
+        const vec3& c = mesh.vertices[mesh.index(triangle * 3 + 2)].pos;
+
+        // The cross product length is twice the area, which is exactly the area weighting.
+        vec3 n = vec3::cross(b - a, c - a);
+
+        if (weighting == NormalWeighting::Area)
+        {
+            return n;
+        }
+
+        const vec3* p[3] = { &a, &b, &c };
+        return n.normalized() * cornerAngle(*p[corner], *p[(corner + 1) % 3], *p[(corner + 2) % 3]);
+    }
+
+public:
+    NormalGenerator(NormalWeighting weighting = NormalWeighting::Area) : weighting(weighting) {}
+
+    const char* Name() const override
+    {
+        return "normal generation";
+    }
+
+    void measureAfter(const Mesh& mesh, StageResult& result) override
+    {
+        result.metrics.push_back({ "generated normals", (double)generatedCount });
+    }
+
+    size_t processImplementation(Mesh& mesh) override
+    {
+        generatedCount = 0;
+
+        std::vector<unsigned int>& indices = mesh.indices();
+        size_t triangleCount = indices.size() / 3;
+        size_t cornerCount = triangleCount * 3;
+        size_t vertexCount = mesh.vertices.size();
+
+        bool missingNormals = false;
+        for (const Vertex& v : mesh.vertices)
+        {
+            if (v.normals.x == 0.0f && v.normals.y == 0.0f && v.normals.z == 0.0f)
+            {
+                missingNormals = true;
+                break;
+            }
+        }
+
+        if (!missingNormals || triangleCount == 0)
+        {
+            return vertexCount * sizeof(Vertex);
+        }
+
+        bool useGroups = mesh.smoothingGroups.size() == triangleCount;
+
+        // 1. Weighted normal of every corner, independent per triangle.
+        std::vector<vec3> cornerNormals(cornerCount);
+
+        parallelFor(triangleCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; ++t)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    cornerNormals[t * 3 + k] = cornerNormal(mesh, t, k);
+                }
+            }
+        });
+
+        // 2. Bucket corners by welded position (counting sort into CSR).
+        std::vector<unsigned int> positionIds;
+        size_t positionCount = weldPositions(mesh.vertices, positionIds);
+
+        std::vector<unsigned int> offsets, corners;
+        bucketCornersById(indices, positionIds, positionCount, offsets, corners);
+
+        // 3. Gather per position: sum the corners that share a smoothing group. Each position owns
+        //    its corners, so the writes to smoothNormals never overlap between threads.
+        std::vector<vec3> smoothNormals(cornerCount);
+
+        parallelFor(positionCount, 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t p = begin; p < end; ++p)
+            {
+                unsigned int* first = &corners[0] + offsets[p];
+                unsigned int* last = &corners[0] + offsets[p + 1];
+
+                if (useGroups)
+                {
+                    std::sort(first, last, [&](unsigned int a, unsigned int b)
+                    {
+                        return mesh.smoothingGroups[a / 3] < mesh.smoothingGroups[b / 3];
+                    });
+                }
+
+                for (unsigned int* run = first; run < last;)
+                {
+                    unsigned int group = useGroups ? mesh.smoothingGroups[*run / 3] : 1;
+                    unsigned int* runEnd = run + 1;
+
+                    if (group != 0)
+                    {
+                        while (runEnd < last && (!useGroups || mesh.smoothingGroups[*runEnd / 3] == group)) ++runEnd;
+                    }
+
+                    vec3 sum(0.0f);
+                    for (unsigned int* c = run; c < runEnd; ++c) sum += cornerNormals[*c];
+
+                    vec3 n = sum.normalized();
+                    for (unsigned int* c = run; c < runEnd; ++c) smoothNormals[*c] = n;
+
+                    run = runEnd;
+                }
+            }
+        });
+
+        // 4. Each vertex takes the normal of its first corner. A vertex shared between faces of
+        //    different groups (only possible with dedup) keeps the first group's normal.
+        const unsigned int unused = std::numeric_limits<unsigned int>::max();
+        std::vector<unsigned int> firstCorner(vertexCount, unused);
+
+        for (size_t c = cornerCount; c-- > 0;)
+        {
+            firstCorner[indices[c]] = (unsigned int)c;
+        }
+
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            const vec3& normal = mesh.vertices[v].normals;
+            if (firstCorner[v] != unused && normal.x == 0.0f && normal.y == 0.0f && normal.z == 0.0f) generatedCount++;
+        }
+
+        parallelFor(vertexCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t v = begin; v < end; ++v)
+            {
+                vec3& normal = mesh.vertices[v].normals;
+
+                if (firstCorner[v] == unused) continue;
+                if (normal.x != 0.0f || normal.y != 0.0f || normal.z != 0.0f) continue;
+
+                normal = smoothNormals[firstCorner[v]];
+            }
+        });
+
+        return cornerCount * sizeof(unsigned int) + vertexCount * sizeof(Vertex);
+    }
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include "../types.h"
+
+#pragma region Helper functions
+// Builds a vertex -> triangles adjacency in CSR form (offsets has vertexCount + 1 entries).
+// Trailing indices that do not form a full triangle are ignored.
+static void buildVertexTriangleAdjacency(const std::vector<unsigned int>& indices, size_t vertexCount,
+    std::vector<unsigned int>& offsets, std::vector<unsigned int>& triangles)
+{
+    size_t indexCount = indices.size() - indices.size() % 3;
+    offsets.assign(vertexCount + 1, 0);
+
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        offsets[indices[i] + 1]++;
+    }
+
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        offsets[v + 1] += offsets[v];
+    }
+
+    triangles.resize(indexCount);
+    std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        triangles[cursor[indices[i]]++] = (unsigned int)(i / 3);
+    }
+}
+
+// Buckets triangle corners by a per-vertex id (welded position, welded vertex...) in CSR form.
+static void bucketCornersById(const std::vector<unsigned int>& indices, const std::vector<unsigned int>& vertexIds, size_t idCount,
+    std::vector<unsigned int>& offsets, std::vector<unsigned int>& corners)
+{
+    size_t cornerCount = indices.size() - indices.size() % 3;
+    offsets.assign(idCount + 1, 0);
+
+    for (size_t c = 0; c < cornerCount; ++c)
+    {
+        offsets[vertexIds[indices[c]] + 1]++;
+    }
+
+    for (size_t i = 0; i < idCount; ++i)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+
+    corners.resize(cornerCount);
+    std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+
+    for (size_t c = 0; c < cornerCount; ++c)
+    {
+        corners[cursor[vertexIds[indices[c]]]++] = (unsigned int)c;
+    }
+}
+#pragma endregion
+
+class PostProcessTemplate
+{
+    public:
+        virtual ~PostProcessTemplate() {}
+
+        virtual const char* Name() const = 0;
+
+        StageResult process(Mesh& mesh)
+        {
+            StageResult result{ this->Name(), std::chrono::microseconds(0), 0, {} };
+
+            // Metrics are gathered outside the timed region so only the stage itself is measured.
+            this->measureBefore(mesh, result);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            result.bytesProcessed = this->processImplementation(mesh);
+            auto end = std::chrono::high_resolution_clock::now();
+            result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+            this->measureAfter(mesh, result);
+
+            return result;
+        }
+
+        virtual void measureBefore(const Mesh& mesh, StageResult& result) {}
+
+        virtual void measureAfter(const Mesh& mesh, StageResult& result) {}
+
+        // Returns the number of bytes the stage touched, used for throughput reporting.
+        virtual size_t processImplementation(Mesh& mesh) = 0;
+};
@@ -0,0 +1,410 @@
+#pragma once
+
+#include "post_process_template.h"
+
+#include <cstdint>
+#include <cstring>
+
+enum class CompactVertexFormat
+{
+    Half,       // fp16 position and normal, 16 bit unorm uv: 16 bytes
+    Quantized   // 16 bit unorm position in the mesh AABB, 16 bit octahedral normal, 16 bit unorm uv: 12 bytes
+};
+
+struct HalfVertex
+{
+    uint16_t pos[3];
+    uint16_t normal[3];
+    uint16_t uv[2];
+};
+
+struct QuantizedVertex
+{
+    uint16_t pos[3];
+    int8_t normal[2];
+    uint16_t uv[2];
+};
+
+// Dequantization: value = min + q * scale, per component.
+struct QuantizationInfo
+{
+    vec3 posMin;
+    vec3 posScale;
+    vec2 uvMin;
+    vec2 uvScale;
+};
+
+#pragma region Helper functions
+static inline uint32_t floatBits(float f)
+{
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static inline float bitsToFloat(uint32_t u)
+{
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Round to nearest even float -> half (F. Giesen, float_to_half_fast3_rtne).
+static inline uint16_t floatToHalf(float value)
+{
+    const uint32_t f32infty = 255u << 23;
+    const uint32_t f16max = (127u + 16u) << 23;
+    const uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t f = floatBits(value);
+    uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint16_t o;
+
+    if (f >= f16max)
+    {
+        o = (f > f32infty) ? 0x7e00 : 0x7c00;
+    }
+    else if (f < (113u << 23))
+    {
+        o = (uint16_t)(floatBits(bitsToFloat(f) + bitsToFloat(denormMagic)) - denormMagic);
+    }
+    else
+    {
+        uint32_t mantOdd = (f >> 13) & 1;
+        f += ((uint32_t)(15 - 127) << 23) + 0xfff;
+        f += mantOdd;
+        o = (uint16_t)(f >> 13);
+    }
+
+    return (uint16_t)(o | (sign >> 16));
+}
+
+static inline float halfToFloat(uint16_t h)
+{
+    const uint32_t shiftedExp = 0x7c00u << 13;
+
+    uint32_t o = (uint32_t)(h & 0x7fff) << 13;
+    uint32_t exp = shiftedExp & o;
+    o += (127u - 15u) << 23;
+
+    if (exp == shiftedExp)
+    {
+        o += (128u - 16u) << 23;
+    }
+    else if (exp == 0)
+    {
+        o += 1u << 23;
+        o = floatBits(bitsToFloat(o) - bitsToFloat(113u << 23));
+    }
+
+    return bitsToFloat(o | ((uint32_t)(h & 0x8000) << 16));
+}
+
+#ifdef OBJ_SSE2
+// Four lanes of floatToHalf, the result sits in the low 16 bits of each 32 bit lane.
+static inline __m128i floatToHalf4(__m128 f)
+{
+    const __m128i signMask = _mm_set1_epi32((int)0x80000000u);
+    const __m128i f16max = _mm_set1_epi32((127 + 16) << 23);
+    const __m128i nanBit = _mm_set1_epi32(0x200);
+    const __m128i infinity = _mm_set1_epi32(0x7c00);
+    const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalBias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+    __m128 justSign = _mm_and_ps(_mm_castsi128_ps(signMask), f);
+    __m128 absF = _mm_xor_ps(f, justSign);
+    __m128i absBits = _mm_castps_si128(absF);
+    __m128i halfSign = _mm_srli_epi32(_mm_castps_si128(justSign), 16);
+
+    __m128 isNan = _mm_cmpunord_ps(absF, absF);
+    __m128i isRegular = _mm_cmpgt_epi32(f16max, absBits);
+    __m128i infOrNan = _mm_or_si128(_mm_and_si128(_mm_castps_si128(isNan), nanBit), infinity);
+    __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+
+    __m128 subnormal1 = _mm_add_ps(absF, _mm_castsi128_ps(subnormalMagic));
+    __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(subnormal1), subnormalMagic);
+
+    __m128i mantOdd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+    __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absBits, normalBias), mantOdd), 13);
+
+    __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    __m128i joined = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infOrNan));
+    return _mm_or_si128(joined, halfSign);
+}
+#endif
+
+// Clamps, then rounds half to even like _mm_cvtps_epi32, so the scalar and SSE2 paths agree on every value.
+static inline uint16_t quantizeUnorm16(float value, float minValue, float invScale)
+{
+    float q = (value - minValue) * invScale;
+    return (uint16_t)std::nearbyint(std::max(0.0f, std::min(65535.0f, q)));
+}
+
+static inline int8_t quantizeSnorm8(float value)
+{
+    float q = std::max(-1.0f, std::min(1.0f, value)) * 127.0f;
+    return (int8_t)(q >= 0.0f ? q + 0.5f : q - 0.5f);
+}
+
+// Octahedral mapping of a unit vector onto [-1, 1]^2 (Cigolle et al. 2014).
+static inline vec2 octahedralEncode(const vec3& n)
+{
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (l1 == 0.0f) return vec2(0.0f);
+
+    vec2 p(n.x / l1, n.y / l1);
+
+    if (n.z < 0.0f)
+    {
+        p = vec2((1.0f - std::fabs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                 (1.0f - std::fabs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+    }
+
+    return p;
+}
+
+static inline vec3 octahedralDecode(const vec2& p)
+{
+    vec3 n(p.x, p.y, 1.0f - std::fabs(p.x) - std::fabs(p.y));
+
+    if (n.z < 0.0f)
+    {
+        float x = n.x;
+        n.x = (1.0f - std::fabs(n.y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        n.y = (1.0f - std::fabs(x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return n.normalized();
+}
+
+static QuantizationInfo computeQuantizationInfo(const std::vector<Vertex>& vertices)
+{
+    vec3 minP(std::numeric_limits<float>::max()), maxP(-std::numeric_limits<float>::max());
+    vec2 minT(std::numeric_limits<float>::max()), maxT(-std::numeric_limits<float>::max());
+
+    for (const Vertex& v : vertices)
+    {
+        minP = vec3(std::min(minP.x, v.pos.x), std::min(minP.y, v.pos.y), std::min(minP.z, v.pos.z));
+        maxP = vec3(std::max(maxP.x, v.pos.x), std::max(maxP.y, v.pos.y), std::max(maxP.z, v.pos.z));
+        minT = vec2(std::min(minT.x, v.textureCoords.x), std::min(minT.y, v.textureCoords.y));
+        maxT = vec2(std::max(maxT.x, v.textureCoords.x), std::max(maxT.y, v.textureCoords.y));
+    }
+
+    if (vertices.empty())
+    {
+        minP = maxP = vec3(0.0f);
+        minT = maxT = vec2(0.0f);
+    }
+
+    vec3 extent = maxP - minP;
+    vec2 uvExtent = maxT - minT;
+
+    QuantizationInfo info;
+    info.posMin = minP;
+    info.posScale = vec3(extent.x / 65535.0f, extent.y / 65535.0f, extent.z / 65535.0f);
+    info.uvMin = minT;
+    info.uvScale = vec2(uvExtent.x / 65535.0f, uvExtent.y / 65535.0f);
+    return info;
+}
+
+static inline float inverseScale(float scale)
+{
+    return scale > 0.0f ? 1.0f / scale : 0.0f;
+}
+#pragma endregion
+
+// Converts loaded meshes to a compact vertex layout and measures what it costs in precision.
+// The mesh AABB has to be known before positions can be quantized, so this runs on the parsed
+// vertex array rather than inside the text parser; the hot loops use SSE2 where available.
+class VertexQuantizer : public PostProcessTemplate
+{
+private:
+    CompactVertexFormat format;
+
+    float maxPositionError = 0.0f;
+    float maxNormalErrorDegrees = 0.0f;
+    float maxUvError = 0.0f;
+
+    void convertHalf(const std::vector<Vertex>& vertices)
+    {
+        lastHalfVertices.resize(vertices.size());
+
+        float uvInv[2] = { inverseScale(lastInfo.uvScale.x), inverseScale(lastInfo.uvScale.y) };
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const Vertex& v = vertices[i];
+            HalfVertex& out = lastHalfVertices[i];
+
+#ifdef OBJ_SSE2
+            // pos.xyz + normal.x and normal.yz in two conversions.
+            alignas(16) uint32_t halves[8];
+            const float* floats = &v.pos.x;
+            _mm_store_si128((__m128i*)halves, floatToHalf4(_mm_loadu_ps(floats)));
+            _mm_store_si128((__m128i*)(halves + 4), floatToHalf4(_mm_loadu_ps(floats + 4)));
+
+            out.pos[0] = (uint16_t)halves[0];
+            out.pos[1] = (uint16_t)halves[1];
+            out.pos[2] = (uint16_t)halves[2];
+            out.normal[0] = (uint16_t)halves[3];
+            out.normal[1] = (uint16_t)halves[4];
+            out.normal[2] = (uint16_t)halves[5];
+#else
+            out.pos[0] = floatToHalf(v.pos.x);
+            out.pos[1] = floatToHalf(v.pos.y);
+            out.pos[2] = floatToHalf(v.pos.z);
+            out.normal[0] = floatToHalf(v.normals.x);
+            out.normal[1] = floatToHalf(v.normals.y);
+            out.normal[2] = floatToHalf(v.normals.z);
+#endif
+            out.uv[0] = quantizeUnorm16(v.textureCoords.x, lastInfo.uvMin.x, uvInv[0]);
+            out.uv[1] = quantizeUnorm16(v.textureCoords.y, lastInfo.uvMin.y, uvInv[1]);
+        }
+    }
+
+    void convertQuantized(const std::vector<Vertex>& vertices)
+    {
+        lastQuantizedVertices.resize(vertices.size());
+
+        float posInv[3] = { inverseScale(lastInfo.posScale.x), inverseScale(lastInfo.posScale.y), inverseScale(lastInfo.posScale.z) };
+        float uvInv[2] = { inverseScale(lastInfo.uvScale.x), inverseScale(lastInfo.uvScale.y) };
+
+#ifdef OBJ_SSE2
+        // Lane layout of the two loads: [pos.x pos.y pos.z n.x] [n.y n.z uv.x uv.y]
+        const __m128 offsetA = _mm_setr_ps(lastInfo.posMin.x, lastInfo.posMin.y, lastInfo.posMin.z, 0.0f);
+        const __m128 scaleA = _mm_setr_ps(posInv[0], posInv[1], posInv[2], 0.0f);
+        const __m128 offsetB = _mm_setr_ps(0.0f, 0.0f, lastInfo.uvMin.x, lastInfo.uvMin.y);
+        const __m128 scaleB = _mm_setr_ps(0.0f, 0.0f, uvInv[0], uvInv[1]);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 maxValue = _mm_set1_ps(65535.0f);
+#endif
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const Vertex& v = vertices[i];
+            QuantizedVertex& out = lastQuantizedVertices[i];
+
+#ifdef OBJ_SSE2
+            const float* floats = &v.pos.x;
+            __m128 a = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(floats), offsetA), scaleA);
+            __m128 b = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(floats + 4), offsetB), scaleB);
+            a = _mm_min_ps(_mm_max_ps(a, zero), maxValue);
+            b = _mm_min_ps(_mm_max_ps(b, zero), maxValue);
+
+            alignas(16) int32_t qa[4], qb[4];
+            _mm_store_si128((__m128i*)qa, _mm_cvtps_epi32(a));
+            _mm_store_si128((__m128i*)qb, _mm_cvtps_epi32(b));
+
+            out.pos[0] = (uint16_t)qa[0];
+            out.pos[1] = (uint16_t)qa[1];
+            out.pos[2] = (uint16_t)qa[2];
+            out.uv[0] = (uint16_t)qb[2];
+            out.uv[1] = (uint16_t)qb[3];
+#else
+            out.pos[0] = quantizeUnorm16(v.pos.x, lastInfo.posMin.x, posInv[0]);
+            out.pos[1] = quantizeUnorm16(v.pos.y, lastInfo.posMin.y, posInv[1]);
+            out.pos[2] = quantizeUnorm16(v.pos.z, lastInfo.posMin.z, posInv[2]);
+            out.uv[0] = quantizeUnorm16(v.textureCoords.x, lastInfo.uvMin.x, uvInv[0]);
+            out.uv[1] = quantizeUnorm16(v.textureCoords.y, lastInfo.uvMin.y, uvInv[1]);
+#endif
+            vec2 oct = octahedralEncode(v.normals);
+            out.normal[0] = quantizeSnorm8(oct.x);
+            out.normal[1] = quantizeSnorm8(oct.y);
+        }
+    }
+
+    void measureErrors(const std::vector<Vertex>& vertices)
+    {
+        maxPositionError = 0.0f;
+        maxNormalErrorDegrees = 0.0f;
+        maxUvError = 0.0f;
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const Vertex& v = vertices[i];
+            vec3 pos, normal;
+            vec2 uv;
+            const uint16_t* quv;
+
+            if (format == CompactVertexFormat::Half)
+            {
+                const HalfVertex& h = lastHalfVertices[i];
+                pos = vec3(halfToFloat(h.pos[0]), halfToFloat(h.pos[1]), halfToFloat(h.pos[2]));
+                normal = vec3(halfToFloat(h.normal[0]), halfToFloat(h.normal[1]), halfToFloat(h.normal[2]));
+                quv = h.uv;
+            }
+            else
+            {
+                const QuantizedVertex& q = lastQuantizedVertices[i];
+                pos = vec3(lastInfo.posMin.x + q.pos[0] * lastInfo.posScale.x,
+                           lastInfo.posMin.y + q.pos[1] * lastInfo.posScale.y,
+                           lastInfo.posMin.z + q.pos[2] * lastInfo.posScale.z);
+                normal = octahedralDecode(vec2(q.normal[0] / 127.0f, q.normal[1] / 127.0f));
+                quv = q.uv;
+            }
+
+            uv = vec2(lastInfo.uvMin.x + quv[0] * lastInfo.uvScale.x, lastInfo.uvMin.y + quv[1] * lastInfo.uvScale.y);
+
+            vec3 d = pos - v.pos;
+            maxPositionError = std::max(maxPositionError, std::max(std::fabs(d.x), std::max(std::fabs(d.y), std::fabs(d.z))));
+            maxUvError = std::max(maxUvError, std::max(std::fabs(uv.x - v.textureCoords.x), std::fabs(uv.y - v.textureCoords.y)));
+
+            vec3 original = v.normals.normalized();
+            if (original.length() > 0.0f && normal.length() > 0.0f)
+            {
+                float c = std::max(-1.0f, std::min(1.0f, vec3::dot(original, normal.normalized())));
+                maxNormalErrorDegrees = std::max(maxNormalErrorDegrees, std::acos(c) * 57.2957795f);
+            }
+        }
+    }
+
+public:
+    // Output of the most recent run; only the array matching the format is filled.
+    std::vector<HalfVertex> lastHalfVertices;
+    std::vector<QuantizedVertex> lastQuantizedVertices;
+    QuantizationInfo lastInfo;
+
+    VertexQuantizer(CompactVertexFormat format = CompactVertexFormat::Quantized) : format(format) {}
+
+    const char* Name() const override
+    {
+        return format == CompactVertexFormat::Half ? "fp16 vertex conversion" : "quantized vertex conversion";
+    }
+
+    size_t compactVertexSize() const
+    {
+        return format == CompactVertexFormat::Half ? sizeof(HalfVertex) : sizeof(QuantizedVertex);
+    }
+
+    void measureAfter(const Mesh& mesh, StageResult& result) override
+    {
+        measureErrors(mesh.vertices);
+
+        double saved = (double)mesh.vertices.size() * (sizeof(Vertex) - compactVertexSize());
+
+        result.metrics.push_back({ "memory saved KB", saved / 1024.0 });
+        result.metrics.push_back({ "memory saved %", 100.0 * (sizeof(Vertex) - compactVertexSize()) / sizeof(Vertex) });
+        result.metrics.push_back({ "max position error", maxPositionError });
+        result.metrics.push_back({ "max normal error deg", maxNormalErrorDegrees });
+        result.metrics.push_back({ "max uv error", maxUvError });
+    }
+
+    size_t processImplementation(Mesh& mesh) override
+    {
+        lastInfo = computeQuantizationInfo(mesh.vertices);
+
+        if (format == CompactVertexFormat::Half)
+        {
+            convertHalf(mesh.vertices);
+        }
+        else
+        {
+            convertQuantized(mesh.vertices);
+        }
+
+        return mesh.vertices.size() * sizeof(Vertex);
+    }
+};
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "post_process_template.h"
+#include "../Utils/parallelFor.h"
+
+#include <cstring>
+
+#pragma region Helper functions
+struct WeldKey
+{
+    unsigned int bits[8];
+
+    bool operator==(const WeldKey& o) const
+    {
+        return std::memcmp(bits, o.bits, sizeof(bits)) == 0;
+    }
+};
+
+struct WeldKeyHash
+{
+    size_t operator()(const WeldKey& k) const
+    {
+        size_t h = 0;
+        for (unsigned int b : k.bits) h = (h ^ b) * 1099511628211ull;
+        return h;
+    }
+};
+
+// Welds vertices that are identical in position, normal and uv, like MikkTSpace does before
+// accumulating, so meshes loaded without dedup still get smooth tangents.
+static size_t weldVertices(const std::vector<Vertex>& vertices, std::vector<unsigned int>& vertexIds)
+{
+    std::unordered_map<WeldKey, unsigned int, WeldKeyHash> ids;
+    ids.reserve(vertices.size());
+    vertexIds.resize(vertices.size());
+
+    for (size_t v = 0; v < vertices.size(); ++v)
+    {
+        const Vertex& vertex = vertices[v];
+        float values[8] = { vertex.pos.x, vertex.pos.y, vertex.pos.z, vertex.normals.x, vertex.normals.y, vertex.normals.z,
+            vertex.textureCoords.x, vertex.textureCoords.y };
+
+        WeldKey key;
+        std::memcpy(key.bits, values, sizeof(values));
+
+        vertexIds[v] = ids.emplace(key, (unsigned int)ids.size()).first->second;
+    }
+
+    return ids.size();
+}
+
+static inline vec3 anyOrthogonal(const vec3& n)
+{
+    vec3 axis = std::fabs(n.x) < 0.9f ? vec3(1, 0, 0) : vec3(0, 1, 0);
+    return vec3::cross(axis, n).normalized();
+}
+#pragma endregion
+
+// Generates per-vertex tangents following the MikkTSpace conventions: tangents are projected onto
+// the vertex normal plane, weighted by corner angle, accumulated over welded vertices separately per
+// uv orientation, and the bitangent is rebuilt as cross(normal, tangent) * tangent.w.
+// The output is kept in an extended vertex layout so the default Vertex stays at 32 bytes.
+class TangentGenerator : public PostProcessTemplate
+{
+private:
+    size_t generatedCount = 0;
+    size_t degenerateCount = 0;
+
+    static vec3 vertexNormal(const Mesh& mesh, unsigned int v, const vec3& faceNormal)
+    {
+        const vec3& n = mesh.vertices[v].normals;
+        return (n.x == 0.0f && n.y == 0.0f && n.z == 0.0f) ? faceNormal : n.normalized();
+    }
+
+public:
+    // Output of the most recent run, indexed like the input mesh vertices.
+    std::vector<TangentVertex> lastVertices;
+
+    const char* Name() const override
+    {
+        return "tangent generation";
+    }
+
+    void measureAfter(const Mesh& mesh, StageResult& result) override
+    {
+        result.metrics.push_back({ "generated tangents", (double)generatedCount });
+        result.metrics.push_back({ "degenerate uv triangles", (double)degenerateCount });
+    }
+
+    size_t processImplementation(Mesh& mesh) override
+    {
+        generatedCount = 0;
+        degenerateCount = 0;
+        lastVertices.clear();
+
+        std::vector<unsigned int>& indices = mesh.indices();
+        size_t triangleCount = indices.size() / 3;
+        size_t cornerCount = triangleCount * 3;
+        size_t vertexCount = mesh.vertices.size();
+
+        bool hasTexcoords = false;
+        for (const Vertex& v : mesh.vertices)
+        {
+            if (v.textureCoords.x != 0.0f || v.textureCoords.y != 0.0f)
+            {
+                hasTexcoords = true;
+                break;
+            }
+        }
+
+        if (!hasTexcoords || triangleCount == 0)
+        {
+            return vertexCount * sizeof(Vertex);
+        }
+
+        // 1. Angle weighted, normal projected tangent of every corner plus the triangle's uv orientation.
+        std::vector<vec3> cornerTangents(cornerCount);
+        std::vector<signed char> cornerOrientation(cornerCount);
+        std::vector<size_t> degeneratePerTriangle(triangleCount, 0);
+
+        parallelFor(triangleCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; ++t)
+            {
+                const unsigned int* tri = &indices[t * 3];
+                const Vertex* v[3] = { &mesh.vertices[tri[0]], &mesh.vertices[tri[1]], &mesh.vertices[tri[2]] };
+
+                vec3 e1 = v[1]->pos - v[0]->pos;
+                vec3 e2 = v[2]->pos - v[0]->pos;
+                vec2 d1 = v[1]->textureCoords - v[0]->textureCoords;
+                vec2 d2 = v[2]->textureCoords - v[0]->textureCoords;
+
+                float signedArea = d1.x * d2.y - d2.x * d1.y;
+                vec3 faceNormal = vec3::cross(e1, e2).normalized();
+                // dP/du scaled by the uv area; only its sign matters, and mirrored uvs flip it back.
+                vec3 faceTangent = (e1 * d2.y - e2 * d1.y) * (signedArea < 0.0f ? -1.0f : 1.0f);
+
+                bool degenerate = std::fabs(signedArea) < 1e-20f || faceTangent.length() == 0.0f;
+                degeneratePerTriangle[t] = degenerate ? 1 : 0;
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    size_t c = t * 3 + k;
+                    cornerOrientation[c] = signedArea >= 0.0f ? 1 : -1;
+
+                    if (degenerate)
+                    {
+                        cornerTangents[c] = vec3(0.0f);
+                        continue;
+                    }
+
+                    vec3 n = vertexNormal(mesh, tri[k], faceNormal);
+                    vec3 tangent = (faceTangent - n * vec3::dot(n, faceTangent)).normalized();
+
+                    vec3 a = (v[(k + 1) % 3]->pos - v[k]->pos).normalized();
+                    vec3 b = (v[(k + 2) % 3]->pos - v[k]->pos).normalized();
+                    float angle = std::acos(std::max(-1.0f, std::min(1.0f, vec3::dot(a, b))));
+
+                    cornerTangents[c] = tangent * angle;
+                }
+            }
+        });
+
+        for (size_t d : degeneratePerTriangle) degenerateCount += d;
+
+        // 2. Gather per welded vertex and orientation; each bucket only writes its own corners.
+        std::vector<unsigned int> vertexIds;
+        size_t idCount = weldVertices(mesh.vertices, vertexIds);
+
+        std::vector<unsigned int> offsets, corners;
+        bucketCornersById(indices, vertexIds, idCount, offsets, corners);
+
+        std::vector<vec3> smoothTangents(cornerCount);
+
+        parallelFor(idCount, 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t id = begin; id < end; ++id)
+            {
+                vec3 sums[2] = { vec3(0.0f), vec3(0.0f) };
+
+                for (unsigned int i = offsets[id]; i < offsets[id + 1]; ++i)
+                {
+                    unsigned int c = corners[i];
+                    sums[cornerOrientation[c] > 0] += cornerTangents[c];
+                }
+
+                for (unsigned int i = offsets[id]; i < offsets[id + 1]; ++i)
+                {
+                    unsigned int c = corners[i];
+                    smoothTangents[c] = sums[cornerOrientation[c] > 0].normalized();
+                }
+            }
+        });
+
+        // 3. Every vertex takes its first corner's tangent, with a fallback basis where uvs are degenerate.
+        const unsigned int unused = std::numeric_limits<unsigned int>::max();
+        std::vector<unsigned int> firstCorner(vertexCount, unused);
+
+        for (size_t c = cornerCount; c-- > 0;)
+        {
+            firstCorner[indices[c]] = (unsigned int)c;
+        }
+
+        lastVertices.resize(vertexCount);
+
+        parallelFor(vertexCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t v = begin; v < end; ++v)
+            {
+                const Vertex& vertex = mesh.vertices[v];
+                unsigned int c = firstCorner[v];
+
+                vec3 n = vertex.normals.normalized();
+                vec3 tangent = c != unused ? smoothTangents[c] : vec3(0.0f);
+                float sign = c != unused ? (float)cornerOrientation[c] : 1.0f;
+
+                if (tangent.length() == 0.0f)
+                {
+                    tangent = anyOrthogonal(n.length() > 0.0f ? n : vec3(0, 0, 1));
+                }
+
+                lastVertices[v] = TangentVertex(vertex, vec4(tangent, sign));
+            }
+        });
+
+        for (unsigned int c : firstCorner)
+        {
+            if (c != unused && smoothTangents[c].length() > 0.0f) generatedCount++;
+        }
+
+        return cornerCount * sizeof(unsigned int) + vertexCount * (sizeof(Vertex) + sizeof(TangentVertex));
+    }
+};
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "post_process_template.h"
+
+#pragma region Helper functions
+// Simulates a FIFO post-transform cache and returns the number of vertex shader invocations.
+template <typename Index>
+static size_t simulateVertexCache(const Index* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+    std::vector<size_t> timestamps(vertexCount, 0);
+    size_t time = cacheSize + 1;
+    size_t misses = 0;
+
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        unsigned int index = indices[i];
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            misses++;
+        }
+    }
+
+    return misses;
+}
+
+template <typename Index>
+static size_t countReferencedVertices(const Index* indices, size_t indexCount, size_t vertexCount)
+{
+    std::vector<bool> referenced(vertexCount, false);
+    size_t count = 0;
+
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        unsigned int index = indices[i];
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// Stable sorts a triangle order by submesh, so triangles keep the optimized order but never leave
+// their draw range.
+static void groupTrianglesBySubmesh(const std::vector<Submesh>& submeshes, std::vector<unsigned int>& triangleOrder)
+{
+    std::vector<unsigned int> owner(triangleOrder.size(), 0);
+    std::vector<size_t> cursor(submeshes.size());
+
+    for (size_t s = 0; s < submeshes.size(); ++s)
+    {
+        size_t first = submeshes[s].indexOffset / 3;
+        size_t last = std::min(owner.size(), (submeshes[s].indexOffset + submeshes[s].indexCount) / 3);
+
+        std::fill(owner.begin() + std::min(first, last), owner.begin() + last, (unsigned int)s);
+        cursor[s] = first;
+    }
+
+    std::vector<unsigned int> grouped(triangleOrder.size());
+    for (unsigned int t : triangleOrder)
+    {
+        grouped[cursor[owner[t]]++] = t;
+    }
+
+    triangleOrder.swap(grouped);
+}
+#pragma endregion
+
+class VertexCacheOptimizer : public PostProcessTemplate
+{
+private:
+    unsigned int cacheSize;
+
+    size_t vertexShaderInvocations(const Mesh& mesh) const
+    {
+        size_t misses = 0;
+        mesh.visitIndices([&](const auto* indices, size_t count)
+        {
+            misses = simulateVertexCache(indices, count, mesh.vertices.size(), cacheSize);
+        });
+
+        return misses;
+    }
+
+    double acmr(const Mesh& mesh) const
+    {
+        size_t triangleCount = mesh.indexCount() / 3;
+        if (triangleCount == 0) return 0.0;
+
+        return (double)vertexShaderInvocations(mesh) / triangleCount;
+    }
+
+    double atvr(const Mesh& mesh) const
+    {
+        size_t referenced = 0;
+        mesh.visitIndices([&](const auto* indices, size_t count)
+        {
+            referenced = countReferencedVertices(indices, count, mesh.vertices.size());
+        });
+        if (referenced == 0) return 0.0;
+
+        return (double)vertexShaderInvocations(mesh) / referenced;
+    }
+
+    // Tipsify (Sander, Nehab, Barczak 2007): fans around the most recently cached vertex that is still
+    // alive, falling back to a dead-end stack and then to a linear cursor over the vertices.
+    void reorderTriangles(Mesh& mesh) const
+    {
+        std::vector<unsigned int>& indices = mesh.indices();
+        size_t vertexCount = mesh.vertices.size();
+        size_t triangleCount = indices.size() / 3;
+
+        std::vector<unsigned int> offsets, adjacency;
+        buildVertexTriangleAdjacency(indices, vertexCount, offsets, adjacency);
+
+        std::vector<unsigned int> liveTriangles(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            liveTriangles[v] = offsets[v + 1] - offsets[v];
+        }
+
+        std::vector<size_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<unsigned int> deadEnd;
+        std::vector<unsigned int> candidates;
+        std::vector<unsigned int> output;
+        std::vector<unsigned int> triangleOrder;
+        output.reserve(indices.size());
+        triangleOrder.reserve(triangleCount);
+
+        size_t time = cacheSize + 1;
+        size_t cursor = 1;
+        long long fanning = vertexCount > 0 ? 0 : -1;
+
+        while (fanning >= 0)
+        {
+            candidates.clear();
+
+            for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+            {
+                unsigned int t = adjacency[a];
+                if (emitted[t]) continue;
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    unsigned int v = indices[t * 3 + k];
+
+                    output.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    liveTriangles[v]--;
+
+                    if (time - cacheTime[v] > cacheSize)
+                    {
+                        cacheTime[v] = time++;
+                    }
+                }
+
+                emitted[t] = true;
+                triangleOrder.push_back(t);
+            }
+
+            // Pick the candidate that will still be in cache and has the oldest entry.
+            long long best = -1;
+            long long bestPriority = -1;
+
+            for (unsigned int v : candidates)
+            {
+                if (liveTriangles[v] == 0) continue;
+
+                long long priority = 0;
+                if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                {
+                    priority = (long long)(time - cacheTime[v]);
+                }
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    best = v;
+                }
+            }
+
+            if (best < 0)
+            {
+                while (!deadEnd.empty())
+                {
+                    unsigned int v = deadEnd.back();
+                    deadEnd.pop_back();
+
+                    if (liveTriangles[v] > 0)
+                    {
+                        best = v;
+                        break;
+                    }
+                }
+            }
+
+            if (best < 0)
+            {
+                while (cursor < vertexCount)
+                {
+                    if (liveTriangles[cursor] > 0)
+                    {
+                        best = (long long)cursor;
+                        break;
+                    }
+                    ++cursor;
+                }
+            }
+
+            fanning = best;
+        }
+
+        if (!mesh.submeshes.empty())
+        {
+            groupTrianglesBySubmesh(mesh.submeshes, triangleOrder);
+
+            output.clear();
+            for (unsigned int t : triangleOrder)
+            {
+                output.insert(output.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+            }
+        }
+
+        // Keep any incomplete trailing triangle as it was.
+        output.insert(output.end(), indices.begin() + triangleCount * 3, indices.end());
+        indices.swap(output);
+
+        // Per-triangle attributes follow their triangles.
+        if (mesh.smoothingGroups.size() == triangleCount)
+        {
+            std::vector<unsigned int> groups(triangleCount);
+            for (size_t t = 0; t < triangleCount; ++t)
+            {
+                groups[t] = mesh.smoothingGroups[triangleOrder[t]];
+            }
+            mesh.smoothingGroups.swap(groups);
+        }
+    }
+
+    // Renumbers vertices in order of first use so the vertex fetch walks memory linearly.
+    // Vertices that are never referenced are kept at the end.
+    void reorderVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) const
+    {
+        const unsigned int unassigned = std::numeric_limits<unsigned int>::max();
+        std::vector<unsigned int> remap(vertices.size(), unassigned);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+
+        for (unsigned int& index : indices)
+        {
+            if (remap[index] == unassigned)
+            {
+                remap[index] = (unsigned int)reordered.size();
+                reordered.push_back(vertices[index]);
+            }
+
+            index = remap[index];
+        }
+
+        for (size_t v = 0; v < vertices.size(); ++v)
+        {
+            if (remap[v] == unassigned)
+            {
+                reordered.push_back(vertices[v]);
+            }
+        }
+
+        vertices.swap(reordered);
+    }
+
+public:
+    VertexCacheOptimizer(unsigned int cacheSize = 16) : cacheSize(cacheSize) {}
+
+    const char* Name() const override
+    {
+        return "vertex cache optimization";
+    }
+
+    void measureBefore(const Mesh& mesh, StageResult& result) override
+    {
+        result.metrics.push_back({ "ACMR before", acmr(mesh) });
+        result.metrics.push_back({ "ATVR before", atvr(mesh) });
+    }
+
+    void measureAfter(const Mesh& mesh, StageResult& result) override
+    {
+        result.metrics.push_back({ "ACMR after", acmr(mesh) });
+        result.metrics.push_back({ "ATVR after", atvr(mesh) });
+    }
+
+    size_t processImplementation(Mesh& mesh) override
+    {
+        reorderTriangles(mesh);
+        reorderVertices(mesh.vertices, mesh.indices());
+
+        return mesh.indexBytes() + mesh.vertices.size() * sizeof(Vertex);
+    }
+};
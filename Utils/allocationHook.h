@@ -0,0 +1,125 @@
+#pragma once
+#include "memoryProfiler.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new and delete so MemoryProbe can count heap traffic. These are the
+// program's replacement functions, so include this from exactly one translation unit. Each block
+// carries its size in a header ahead of the pointer, which lets delete count the bytes freed. Over-
+// aligned allocations keep the library's own operators and are not counted. fast_obj is C and allocates
+// with realloc and free, so it is built against countedRealloc and countedFree below instead.
+static const size_t allocationHeaderBytes = alignof(std::max_align_t);
+
+void* operator new(size_t size)
+{
+    if (!profileAllocations)
+    {
+        void* block = std::malloc(size ? size : 1);
+        if (!block) throw std::bad_alloc();
+        return block;
+    }
+
+    char* block = (char*)std::malloc(size + allocationHeaderBytes);
+    if (!block) throw std::bad_alloc();
+
+    *(size_t*)block = size;
+    allocationCounters().recordAllocation(size);
+    return block + allocationHeaderBytes;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (!pointer) return;
+
+    if (!profileAllocations)
+    {
+        std::free(pointer);
+        return;
+    }
+
+    char* block = (char*)pointer - allocationHeaderBytes;
+    allocationCounters().recordFree(*(size_t*)block);
+    std::free(block);
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
+
+// Same header scheme as operator new. The new size is counted before the old one is released, since
+// realloc may hold both blocks at once.
+extern "C" void* countedRealloc(void* pointer, size_t size)
+{
+    if (!profileAllocations) return std::realloc(pointer, size);
+
+    char* old = pointer ? (char*)pointer - allocationHeaderBytes : nullptr;
+    size_t oldSize = old ? *(size_t*)old : 0;
+
+    char* block = (char*)std::realloc(old, size + allocationHeaderBytes);
+    if (!block) return nullptr;
+
+    *(size_t*)block = size;
+    allocationCounters().recordAllocation(size);
+    if (old) allocationCounters().recordFree(oldSize);
+    return block + allocationHeaderBytes;
+}
+
+extern "C" void countedFree(void* pointer)
+{
+    if (!pointer) return;
+
+    if (!profileAllocations)
+    {
+        std::free(pointer);
+        return;
+    }
+
+    char* block = (char*)pointer - allocationHeaderBytes;
+    allocationCounters().recordFree(*(size_t*)block);
+    std::free(block);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "../types.h"
+
+#include "../Implementations/new_fast.h"
+
+#include <filesystem>
+
+// Decode-only and decode+parse throughput over compressed objs. When the uncompressed obj sits next to
+// the archive it is parsed too, so the pipelined time can be compared with decoding and parsing back to back.
+std::vector<Results> runCompressedLoads(NewFast* loader, const std::vector<std::string>& paths)
+{
+    static std::string name = std::string(loader->Name()) + " (compressed input)";
+
+    std::vector<Results> results{};
+    if (paths.empty())
+    {
+        return results;
+    }
+
+    size_t compressedBytes = 0;
+    size_t decompressedBytes = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const std::string& path : paths)
+    {
+        CompressedObjStream stream;
+        if (!stream.open(path)) continue;
+
+        std::vector<char> chunk;
+        while (stream.read(chunk))
+        {
+            decompressedBytes += chunk.size();
+        }
+
+        compressedBytes += stream.compressedSize();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double decodeMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<Result> data = loader->loadAllObjs(paths);
+    end = std::chrono::high_resolution_clock::now();
+    double pipelinedMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::vector<std::string> plainPaths;
+    for (const std::string& path : paths)
+    {
+        std::string plain = path.substr(0, path.find_last_of('.'));
+        if (std::filesystem::exists(plain)) plainPaths.push_back(plain);
+    }
+
+    double mb = decompressedBytes / (1024.0 * 1024.0);
+
+    MetricList metrics = {
+        { "Files", (double)paths.size() },
+        { "Compressed MB", compressedBytes / (1024.0 * 1024.0) },
+        { "Decompressed MB", mb },
+        { "Decode only MB/s", decodeMs > 0 ? mb / (decodeMs / 1000.0) : 0.0 },
+        { "Decode + parse MB/s", pipelinedMs > 0 ? mb / (pipelinedMs / 1000.0) : 0.0 },
+        { "Decode + parse ms", pipelinedMs }
+    };
+
+    if (plainPaths.size() == paths.size())
+    {
+        start = std::chrono::high_resolution_clock::now();
+        for (const std::string& path : plainPaths)
+        {
+            Mesh mesh = loader->loadObjImplementation(path);
+        }
+        end = std::chrono::high_resolution_clock::now();
+        double parseMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        metrics.push_back({ "Parse only MB/s", parseMs > 0 ? mb / (parseMs / 1000.0) : 0.0 });
+        metrics.push_back({ "Decode then parse ms", decodeMs + parseMs });
+    }
+
+    results.push_back({ name.c_str(), data, metrics });
+
+    return results;
+};
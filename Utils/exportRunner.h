@@ -0,0 +1,133 @@
+#pragma once
+#include "../types.h"
+
+#include "../Implementations/loader_template.h"
+#include "../Exporters/obj_writer.h"
+#include "../Exporters/ply_writer.h"
+#include "../Exporters/stl_writer.h"
+
+#include <filesystem>
+
+// Writes the binary PLY, ASCII PLY and binary STL copies of every obj that the PLY and STL loaders
+// read, so every format is benchmarked on the same geometry.
+void writeInterchangeFiles(LoaderTemplate* loader, const std::vector<std::string>& paths)
+{
+    std::error_code error;
+    std::filesystem::create_directories(interchangeFolderPath, error);
+
+    for (const std::string& path : paths)
+    {
+        Mesh mesh = loader->loadObjImplementation(path);
+
+        bool ok = writePly(mesh, interchangePath(path, ".ply")) > 0;
+        ok &= writePly(mesh, interchangePath(path, ".ascii.ply"), true) > 0;
+        ok &= writeStl(mesh, interchangePath(path, ".stl")) > 0;
+
+        if (!ok)
+        {
+            std::cout << "Failed to convert " << path << "\n";
+        }
+    }
+}
+
+// The obj writer prints floats with std::to_chars, the shortest text that reads back as the same float,
+// so a reloaded triangle has to resolve to exactly the positions it was written from.
+static bool sameTriangleCorners(const Mesh& written, const Mesh& reloaded)
+{
+    if (written.indexCount() != reloaded.indexCount()) return false;
+
+    for (size_t i = 0; i < written.indexCount(); ++i)
+    {
+        unsigned int a = written.index(i);
+        unsigned int b = reloaded.index(i);
+        if (a >= written.vertices.size() || b >= reloaded.vertices.size()) return false;
+
+        const vec3& p = written.vertices[a].pos;
+        const vec3& q = reloaded.vertices[b].pos;
+        if (p.x != q.x || p.y != q.y || p.z != q.z) return false;
+    }
+
+    return true;
+}
+
+// Loads every file once, then writes the meshes back out and reports write throughput next to the
+// read throughput of the same loader. The exported files are loaded again as a round trip check.
+std::vector<Results> runExports(LoaderTemplate* loader, const std::vector<std::string>& paths, const std::string& exportFolderPath)
+{
+    std::vector<Results> results{};
+
+    std::error_code error;
+    std::filesystem::create_directories(exportFolderPath, error);
+
+    std::vector<Mesh> meshes;
+    std::vector<std::string> exportPaths;
+    size_t readBytes = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const std::string& path : paths)
+    {
+        meshes.push_back(loader->loadObjImplementation(path));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double readMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    for (const std::string& path : paths)
+    {
+        readBytes += (size_t)std::filesystem::file_size(path, error);
+        exportPaths.push_back(exportFolderPath + pathSeparator + flattenedFileName(path));
+    }
+
+    // writer(mesh, path) returns the bytes written; extension replaces ".obj" in the exported name.
+    auto timeWrites = [&](auto writer, const char* extension, size_t& bytes)
+    {
+        bytes = 0;
+        auto writeStart = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            bytes += writer(meshes[i], exportPaths[i].substr(0, exportPaths[i].size() - 4) + extension);
+        }
+        auto writeEnd = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(writeEnd - writeStart).count();
+    };
+
+    auto megabytesPerSecond = [](size_t bytes, double ms)
+    {
+        return ms > 0 ? (bytes / (1024.0 * 1024.0)) / (ms / 1000.0) : 0.0;
+    };
+
+    size_t sequentialBytes, parallelBytes, plyBytes, stlBytes;
+    double sequentialMs = timeWrites([](const Mesh& m, const std::string& p) { return writeObj(m, p, false); }, ".obj", sequentialBytes);
+    double parallelMs = timeWrites([](const Mesh& m, const std::string& p) { return writeObj(m, p, true); }, ".obj", parallelBytes);
+    double plyMs = timeWrites([](const Mesh& m, const std::string& p) { return writePly(m, p); }, ".ply", plyBytes);
+    double stlMs = timeWrites([](const Mesh& m, const std::string& p) { return writeStl(m, p); }, ".stl", stlBytes);
+
+    bool roundTripOk = true;
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        Mesh reloaded = loader->loadObjImplementation(exportPaths[i]);
+        roundTripOk &= sameTriangleCorners(meshes[i], reloaded);
+    }
+
+    results.push_back({ "obj writer", {}, {
+        { "Files", (double)paths.size() },
+        { "Written MB", parallelBytes / (1024.0 * 1024.0) },
+        { "Read MB/s", megabytesPerSecond(readBytes, readMs) },
+        { "Write MB/s", megabytesPerSecond(sequentialBytes, sequentialMs) },
+        { "Parallel write MB/s", megabytesPerSecond(parallelBytes, parallelMs) },
+        { "Round trip ok", roundTripOk ? 1.0 : 0.0 }
+    } });
+
+    results.push_back({ "binary ply writer", {}, {
+        { "Files", (double)paths.size() },
+        { "Written MB", plyBytes / (1024.0 * 1024.0) },
+        { "Write MB/s", megabytesPerSecond(plyBytes, plyMs) }
+    } });
+
+    results.push_back({ "binary stl writer", {}, {
+        { "Files", (double)paths.size() },
+        { "Written MB", stlBytes / (1024.0 * 1024.0) },
+        { "Write MB/s", megabytesPerSecond(stlBytes, stlMs) }
+    } });
+
+    return results;
+};
@@ -7,6 +7,12 @@
 #include "../Implementations/tiny_obj_loader.h"
 #include "../Implementations/fast_obj.h"
 #include "../Implementations/new_fast.h"
+#include "../Implementations/binary_cache.h"
+#include "../Implementations/cached_loader.h"
+#include "../Implementations/ply_loader.h"
+#include "../Implementations/stl_loader.h"
+
+#include "postProcessRunner.h"
 
 std::vector<LoaderTemplate*>& GetRegistry()
 {
@@ -37,6 +43,32 @@ static Registrar registerD(&fastObjImplementation);
 static NewFast newFastImplementation;
 static Registrar registerE(&newFastImplementation);
 
+static BinaryMeshCache binaryMeshCacheImplementation;
+static Registrar registerF(&binaryMeshCacheImplementation);
+
+static CachedLoader cachedNewFastImplementation(&newFastImplementation);
+static Registrar registerG(&cachedNewFastImplementation);
+
+static PlyLoader binaryPlyImplementation("Binary PLY", ".ply");
+static Registrar registerH(&binaryPlyImplementation);
+
+static PlyLoader asciiPlyImplementation("ASCII PLY", ".ascii.ply");
+static Registrar registerI(&asciiPlyImplementation);
+
+static StlLoader stlImplementation;
+static Registrar registerJ(&stlImplementation);
+
+// Same parser with 'o', 'g' and 'usemtl' ignored, to show what building submeshes costs.
+static NewFast newFastFlatImplementation(false);
+static Registrar registerK(&newFastFlatImplementation);
+
+// Same parser forced to one triangulation, to show what fan and ear clipping cost next to the default.
+static NewFast newFastFanImplementation(true, kernelIsa, TriangulationMode::Fan);
+static Registrar registerL(&newFastFanImplementation);
+
+static NewFast newFastEarClipImplementation(true, kernelIsa, TriangulationMode::EarClip);
+static Registrar registerM(&newFastEarClipImplementation);
+
 std::vector<Results> runImplementations(const std::vector<std::string> paths)
 {
 	std::vector<Results> results{};
@@ -44,7 +76,9 @@ std::vector<Results> runImplementations(const std::vector<std::string> paths)
 	for (LoaderTemplate* p : GetRegistry())
 	{
 		std::cout << "\nRunning: " << p->Name() << "\n\n";
-		results.push_back({ p->Name(), p->loadAllObjs(paths) });
+		results.push_back({ p->Name(), p->loadAllObjs(paths), {} });
+		results.back().metrics = p->Metrics();
+		runPostProcessing(results.back().data);
 	}
 
 	return results;
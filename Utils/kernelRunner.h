@@ -0,0 +1,120 @@
+#pragma once
+#include "../types.h"
+
+#include "../Implementations/new_fast.h"
+
+#include <cstring>
+
+#pragma region Helper functions
+static bool sameGeometry(const Mesh& a, const Mesh& b)
+{
+    if (a.vertices.size() != b.vertices.size() || a.indexCount() != b.indexCount() || a.submeshes.size() != b.submeshes.size()) return false;
+
+    for (size_t i = 0; i < a.indexCount(); ++i)
+    {
+        if (a.index(i) != b.index(i)) return false;
+    }
+
+    return a.vertices.empty() || std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(Vertex)) == 0;
+}
+#pragma endregion
+
+// NewFast with every parse kernel set this CPU supports, on the same files in the same run: parse
+// throughput, the newline scan alone, and whether the meshes match the scalar kernels bit for bit.
+std::vector<Results> runKernelComparison(const std::vector<std::string>& paths, unsigned int repeats)
+{
+    std::vector<std::string> texts;
+    size_t bytes = 0;
+
+    for (const std::string& path : paths)
+    {
+        MappedFile file;
+        if (!file.open(path) || file.size == 0) continue;
+
+        texts.emplace_back(file.data, file.size);
+        bytes += file.size;
+    }
+
+    double mb = bytes * (double)repeats / (1024.0 * 1024.0);
+
+    static std::vector<std::string> names;
+    names.clear();
+
+    std::vector<Results> results{};
+    std::vector<Mesh> reference;
+    double scalarMs = 0.0;
+
+    const KernelIsa isas[] = { KernelIsa::Scalar, KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::AVX512 };
+    for (KernelIsa isa : isas)
+    {
+        if ((int)isa > (int)supportedKernelIsa()) break;
+
+        NewFast loader(true, isa);
+        ParseKernels kernels = selectParseKernels(isa);
+
+        // One untimed pass first, so the parse buffers have grown to size before the clock starts.
+        for (const std::string& path : paths) loader.loadObjImplementation(path);
+
+        std::vector<Mesh> meshes;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned int r = 0; r < repeats; ++r)
+        {
+            meshes.clear();
+            for (const std::string& path : paths)
+            {
+                meshes.push_back(loader.loadObjImplementation(path));
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double parseMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        size_t lines = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (unsigned int r = 0; r < repeats; ++r)
+        {
+            for (const std::string& text : texts)
+            {
+                const char* p = text.data();
+                const char* textEnd = p + text.size();
+                while (p < textEnd)
+                {
+                    p = kernels.findNewline(p, textEnd) + 1;
+                    ++lines;
+                }
+            }
+        }
+        end = std::chrono::high_resolution_clock::now();
+        double scanMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        bool matches = true;
+        if (isa == KernelIsa::Scalar)
+        {
+            reference = meshes;
+            scalarMs = parseMs;
+        }
+        else
+        {
+            for (size_t m = 0; m < meshes.size() && matches; ++m)
+            {
+                matches = sameGeometry(meshes[m], reference[m]);
+            }
+        }
+
+        names.push_back(std::string(kernelIsaName(isa)) + " kernels");
+
+        results.push_back({ nullptr, {}, {
+            { "Parse MB/s", parseMs > 0 ? mb / (parseMs / 1000.0) : 0.0 },
+            { "Newline scan MB/s", scanMs > 0 ? mb / (scanMs / 1000.0) : 0.0 },
+            { "Lines", (double)(lines / std::max(1u, repeats)) },
+            { "Speedup over scalar", parseMs > 0 ? scalarMs / parseMs : 0.0 },
+            { "Matches scalar", matches ? 1.0 : 0.0 }
+        } });
+    }
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        results[i].implementationName = names[i].c_str();
+    }
+
+    return results;
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include "../types.h"
+
+#include "../Implementations/mtl_parser.h"
+#include "../Implementations/tiny_obj_loader.h"
+
+#include <map>
+
+#pragma region Helper functions
+// Paths of the libraries an obj names in its 'mtllib' statements, relative to the obj's folder.
+static std::vector<std::string> findMaterialLibraries(const std::string& objPath)
+{
+    std::vector<std::string> libraries;
+
+    MappedFile file;
+    if (!file.open(objPath) || file.size == 0)
+    {
+        return libraries;
+    }
+
+    size_t slash = objPath.find_last_of("\\/");
+    std::string folder = slash == std::string::npos ? "" : objPath.substr(0, slash + 1);
+
+    const char* data = file.data;
+    const char* end = data + file.size;
+
+    while (data < end)
+    {
+        const char* lineStart = data;
+        while (data < end && *data != '\n') data++;
+        const char* lineEnd = data;
+        if (data < end) data++;
+
+        if (lineEnd - lineStart <= 6 || std::memcmp(lineStart, "mtllib", 6) != 0) continue;
+
+        const char* p = lineStart + 6;
+        while (p < lineEnd)
+        {
+            while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+            const char* a = p; while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+            if (p > a) libraries.push_back(folder + std::string(a, p));
+        }
+    }
+
+    return libraries;
+}
+
+// MTL text with count materials in the layout common exporters write. Textures repeat every 64
+// materials, the case interning is for.
+static std::string generateSyntheticMaterials(unsigned int count)
+{
+    std::string text = "# synthetic material library\n";
+    char line[128];
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float shade = (i % 97) / 96.0f;
+
+        text += "\nnewmtl material_" + std::to_string(i) + "\n";
+        text += "Ns 96.078431\nKa 1.000000 1.000000 1.000000\n";
+        std::snprintf(line, sizeof(line), "Kd %f %f %f\n", shade, 1.0f - shade, 0.5f);
+        text += line;
+        text += "Ks 0.500000 0.500000 0.500000\nKe 0.000000 0.000000 0.000000\nNi 1.450000\nd 1.000000\nillum 2\n";
+        text += "map_Kd textures/albedo_" + std::to_string(i % 64) + ".png\n";
+        text += "map_Bump -bm 1.000000 textures/normal_" + std::to_string(i % 64) + ".png\n";
+    }
+
+    return text;
+}
+#pragma endregion
+
+// MTL parse throughput of parseMtl against tinyobj's LoadMtl, over the libraries the scanned objs
+// reference plus a generated one with syntheticCount materials. The text is read into memory first,
+// so only parsing is timed, repeats times over.
+std::vector<Results> runMaterialLoads(const std::vector<std::string>& paths, unsigned int syntheticCount, unsigned int repeats)
+{
+    std::vector<std::string> texts;
+    size_t files = 0;
+
+    for (const std::string& path : paths)
+    {
+        for (const std::string& library : findMaterialLibraries(path))
+        {
+            MappedFile file;
+            if (!file.open(library) || file.size == 0) continue;
+
+            texts.emplace_back(file.data, file.size);
+            ++files;
+        }
+    }
+
+    texts.push_back(generateSyntheticMaterials(syntheticCount));
+
+    size_t bytes = 0;
+    for (const std::string& text : texts)
+    {
+        bytes += text.size();
+    }
+
+    size_t materials = 0, strings = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int r = 0; r < repeats; ++r)
+    {
+        materials = strings = 0;
+        for (const std::string& text : texts)
+        {
+            MaterialLibrary library;
+            parseMtl(text.data(), text.data() + text.size(), library);
+            materials += library.materials.size();
+            strings += library.stringCount();
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double parseMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    // tinyobj reads from a stream. The streams are built before the clock starts so copying the text
+    // into them is not timed; each pass only rewinds them.
+    std::vector<std::istringstream> streams;
+    streams.reserve(texts.size());
+    for (const std::string& text : texts) streams.emplace_back(text);
+
+    size_t tinyMaterials = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned int r = 0; r < repeats; ++r)
+    {
+        tinyMaterials = 0;
+        for (std::istringstream& stream : streams)
+        {
+            stream.clear();
+            stream.seekg(0);
+
+            std::map<std::string, int> materialMap;
+            std::vector<tinyobj::material_t> tinyLibrary;
+            std::string warning, error;
+
+            tinyobj::LoadMtl(&materialMap, &tinyLibrary, &stream, &warning, &error);
+            tinyMaterials += tinyLibrary.size();
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double tinyMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    double mb = bytes * (double)repeats / (1024.0 * 1024.0);
+
+    std::vector<Results> results{};
+
+    results.push_back({ "mtl parser", {}, {
+        { "Files", (double)files },
+        { "Synthetic materials", (double)syntheticCount },
+        { "Materials", (double)materials },
+        { "Interned strings", (double)strings },
+        { "Parse MB/s", parseMs > 0 ? mb / (parseMs / 1000.0) : 0.0 },
+        { "Parse ms per pass", parseMs / repeats },
+        { "Speedup over tinyobj", parseMs > 0 ? tinyMs / parseMs : 0.0 }
+    } });
+
+    results.push_back({ "tinyobj LoadMtl", {}, {
+        { "Materials", (double)tinyMaterials },
+        { "Parse MB/s", tinyMs > 0 ? mb / (tinyMs / 1000.0) : 0.0 },
+        { "Parse ms per pass", tinyMs / repeats }
+    } });
+
+    return results;
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include "../types.h"
+
+#include <atomic>
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Process-wide heap counters, fed by the replaced operator new in allocationHook.h. Inline rather than
+// static so every translation unit sees the same counters.
+struct AllocationCounters
+{
+    std::atomic<size_t> allocations{ 0 };
+    std::atomic<size_t> allocatedBytes{ 0 };
+    std::atomic<size_t> freedBytes{ 0 };
+    std::atomic<size_t> liveBytes{ 0 };
+    std::atomic<size_t> peakBytes{ 0 };
+
+    void recordAllocation(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+        size_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+
+    void recordFree(size_t size)
+    {
+        freedBytes.fetch_add(size, std::memory_order_relaxed);
+        liveBytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+};
+
+inline AllocationCounters& allocationCounters()
+{
+    static AllocationCounters counters;
+    return counters;
+}
+
+#pragma region Helper functions
+// High-water mark of the process's resident set in bytes.
+static size_t peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+#pragma endregion
+
+// Memory used between start() and stop(). The heap peak is reset at start, so it is the most the load
+// held at once on top of what was live before. Loads run one at a time, but threads a load starts are
+// counted too.
+class MemoryProbe
+{
+private:
+    size_t allocations = 0;
+    size_t allocatedBytes = 0;
+    size_t freedBytes = 0;
+    size_t liveBytes = 0;
+    size_t peakResident = 0;
+
+public:
+    void start()
+    {
+        AllocationCounters& counters = allocationCounters();
+        allocations = counters.allocations.load(std::memory_order_relaxed);
+        allocatedBytes = counters.allocatedBytes.load(std::memory_order_relaxed);
+        freedBytes = counters.freedBytes.load(std::memory_order_relaxed);
+        liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+        counters.peakBytes.store(liveBytes, std::memory_order_relaxed);
+        peakResident = peakResidentBytes();
+    }
+
+    MemoryUsage stop() const
+    {
+        AllocationCounters& counters = allocationCounters();
+        size_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+        size_t resident = peakResidentBytes();
+
+        MemoryUsage usage;
+        usage.allocations = counters.allocations.load(std::memory_order_relaxed) - allocations;
+        usage.allocatedBytes = counters.allocatedBytes.load(std::memory_order_relaxed) - allocatedBytes;
+        usage.freedBytes = counters.freedBytes.load(std::memory_order_relaxed) - freedBytes;
+        usage.peakHeapBytes = peak > liveBytes ? peak - liveBytes : 0;
+        usage.peakRssGrowth = resident > peakResident ? resident - peakResident : 0;
+        return usage;
+    }
+};
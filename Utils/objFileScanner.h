@@ -1,14 +1,65 @@
 #pragma once
 #include "../types.h"
 
+#include "../Implementations/compressed_stream.h"
+#include "../Implementations/parse_kernels.h"
+#include "traceEvents.h"
+
+#include <filesystem>
+
 bool HasObjExtension(const std::string& filename)
 {
     size_t dot = filename.find_last_of('.');
     return dot != std::string::npos && filename.substr(dot) == ".obj";
 }
 
+// Counts lines starting with "v " in one buffer; newLine carries the state across buffers.
+size_t CountVerticesInBuffer(const char* buffer, size_t bytesRead, bool& newLine)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < bytesRead; i++)
+    {
+        char c = buffer[i];
+
+        if (newLine && c == 'v')
+        {
+            if (i + 1 < bytesRead && buffer[i + 1] == ' ')
+            {
+                count++;
+            }
+        }
+
+        newLine = (c == '\n');
+    }
+
+    return count;
+}
+
+// The original serial counter: an ifstream read in 1 MB chunks and a byte loop. Kept as the baseline
+// the folder scan comparison measures ObjFolderScanner against.
 size_t CountVerticesInObj(const std::string& filePath)
 {
+    size_t count = 0;
+    bool newLine = true;
+
+    if (CompressedObjStream::isCompressed(filePath))
+    {
+        CompressedObjStream stream;
+        if (!stream.open(filePath))
+        {
+            return 0;
+        }
+
+        std::vector<char> chunk;
+        while (stream.read(chunk))
+        {
+            count += CountVerticesInBuffer(chunk.data(), chunk.size(), newLine);
+        }
+
+        return count;
+    }
+
     std::ifstream file(filePath.c_str(), std::ios::binary);
     if (!file)
     {
@@ -18,75 +69,370 @@ size_t CountVerticesInObj(const std::string& filePath)
     const size_t bufferSize = 1024 * 1024; // 1 MB buffer
     std::vector<char> buffer(bufferSize);
 
-    size_t count = 0;
-    bool newLine = true;
-
     while (file)
     {
         file.read(buffer.data(), bufferSize);
         size_t bytesRead = (size_t)file.gcount();
 
-        for (size_t i = 0; i < bytesRead; i++)
+        count += CountVerticesInBuffer(buffer.data(), bytesRead, newLine);
+    }
+
+    return count;
+}
+
+// Counts lines starting with "v " with the given kernels. Plain objs are mapped and counted in one
+// pass; compressed ones are counted chunk by chunk, carrying line starts across chunk borders.
+size_t countObjVertices(const std::string& filePath, const ParseKernels& kernels)
+{
+    if (!CompressedObjStream::isCompressed(filePath))
+    {
+        MappedFile file;
+        if (!file.open(filePath))
         {
-            char c = buffer[i];
+            return 0;
+        }
 
-            if (newLine && c == 'v')
+        return kernels.countVertexLines(file.data, file.data + file.size);
+    }
+
+    CompressedObjStream stream;
+    if (!stream.open(filePath))
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    bool lineStart = true;
+    bool pendingVertex = false;
+
+    std::vector<char> chunk;
+    while (stream.read(chunk))
+    {
+        if (chunk.empty()) continue;
+
+        const char* data = chunk.data();
+        size_t size = chunk.size();
+
+        // The kernel takes every chunk as the start of a line, and a "v " may be split by the border.
+        count += kernels.countVertexLines(data, data + size);
+        if (!lineStart && size >= 2 && data[0] == 'v' && data[1] == ' ') --count;
+        if (pendingVertex && data[0] == ' ') ++count;
+
+        pendingVertex = data[size - 1] == 'v' && (size >= 2 ? data[size - 2] == '\n' : lineStart);
+        lineStart = data[size - 1] == '\n';
+    }
+
+    return count;
+}
+
+#pragma region Helper functions
+// '*' matches within one folder, '**' across folders ("**/" also matches no folder at all) and '?'
+// matches one character other than '/'; everything else matches itself.
+static bool matchesGlob(const char* pattern, const char* text)
+{
+    while (*pattern)
+    {
+        if (pattern[0] == '*' && pattern[1] == '*')
+        {
+            pattern += 2;
+            if (*pattern == '/' && matchesGlob(pattern + 1, text)) return true;
+
+            for (;; ++text)
             {
-                if (i + 1 < bytesRead && buffer[i + 1] == ' ')
-                {
-                    count++;
-                }
+                if (matchesGlob(pattern, text)) return true;
+                if (!*text) return false;
             }
+        }
 
-            newLine = (c == '\n');
+        if (*pattern == '*')
+        {
+            ++pattern;
+            for (;; ++text)
+            {
+                if (matchesGlob(pattern, text)) return true;
+                if (!*text || *text == '/') return false;
+            }
         }
+
+        if (!*text) return false;
+        if (*pattern == '?' ? *text == '/' : *pattern != *text) return false;
+
+        ++pattern;
+        ++text;
     }
 
-    return count;
+    return !*text;
 }
 
-std::vector<std::string> scanFolderForObjFiles(const std::string& folderPath)
+static std::vector<std::string> splitPatterns(const char* patterns)
 {
     std::vector<std::string> result;
+    std::stringstream stream(patterns);
+    std::string pattern;
+
+    while (std::getline(stream, pattern, ';'))
+    {
+        if (!pattern.empty()) result.push_back(pattern);
+    }
+    return result;
+}
+#pragma endregion
+
+enum class ScanOrder { Path, LargestFirst };
+
+// Which files a scan picks up and in what order; the defaults are the scan settings at the top of
+// ObjLoaderBenchmark.cpp. Patterns are matched against the path below the scanned folder with '/'
+// separators, or against the file name alone when they hold no '/'. The extension check stays in
+// place, so include patterns narrow the objs down rather than adding other files.
+struct ObjScanOptions
+{
+    bool recursive = scanRecursively;
+    std::vector<std::string> include = splitPatterns(scanIncludePatterns);
+    std::vector<std::string> exclude = splitPatterns(scanExcludePatterns);
+    uint64_t minBytes = scanMinFileBytes;
+    uint64_t maxBytes = scanMaxFileBytes; // 0 for no limit
+    ScanOrder order = scanLargestFirst ? ScanOrder::LargestFirst : ScanOrder::Path;
+
+    static bool anyMatches(const std::vector<std::string>& patterns, const std::string& relativePath, const std::string& filename)
+    {
+        for (const std::string& pattern : patterns)
+        {
+            const std::string& text = pattern.find('/') == std::string::npos ? filename : relativePath;
+            if (matchesGlob(pattern.c_str(), text.c_str())) return true;
+        }
+        return false;
+    }
+
+    bool excludes(const std::string& relativePath, const std::string& filename) const
+    {
+        return anyMatches(exclude, relativePath, filename);
+    }
 
-    std::string searchPath = folderPath + "\\*";
-    WIN32_FIND_DATAA findData;
-    HANDLE handle = FindFirstFileA(searchPath.c_str(), &findData);
+    bool includes(const std::string& relativePath, const std::string& filename) const
+    {
+        return (include.empty() || anyMatches(include, relativePath, filename)) && !excludes(relativePath, filename);
+    }
 
-    if (handle == INVALID_HANDLE_VALUE)
+    bool sizeAllowed(uint64_t size) const
     {
-        std::cout << "Folder not found: " << folderPath << std::endl;
-        return result;
+        return size >= minBytes && (maxBytes == 0 || size <= maxBytes);
     }
+};
+
+// Calls found(path) for every file under folderPath with the right extension that the options'
+// patterns let through. Excluded folders are not entered.
+template <typename Found>
+void forEachObjFile(const std::string& folderPath, bool compressed, const ObjScanOptions& options, Found found)
+{
+    using namespace std::filesystem;
+
+    path root(folderPath);
+    std::error_code error;
+    recursive_directory_iterator entries(root, directory_options::skip_permission_denied, error);
 
-    do
+    for (; !error && entries != recursive_directory_iterator(); entries.increment(error))
     {
-        std::string filename = findData.cFileName;
+        const directory_entry& entry = *entries;
+        std::string filename = entry.path().filename().string();
+        std::string relativePath = entry.path().lexically_relative(root).generic_string();
 
-        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        if (entry.is_directory(error))
         {
+            if (!options.recursive || options.excludes(relativePath, filename)) entries.disable_recursion_pending();
             continue;
         }
 
-        if (!HasObjExtension(filename))
+        if (compressed ? !CompressedObjStream::isSupported(filename) : !HasObjExtension(filename))
         {
             continue;
         }
 
-        if (filename.size() > 4 && filename.substr(filename.size() - 4) == ".obj")
+        if (options.includes(relativePath, filename))
+        {
+            found(entry.path().string());
+        }
+    }
+}
+
+struct ScannedObjFile
+{
+    std::string path;
+    uint64_t size = 0;
+    size_t vertexCount = 0;
+};
+
+// Sorts by path, or largest first with ties by path; either way the order is the same on every platform.
+void sortScannedFiles(std::vector<ScannedObjFile>& files, ScanOrder order)
+{
+    std::sort(files.begin(), files.end(), [order](const ScannedObjFile& a, const ScannedObjFile& b)
+    {
+        if (order == ScanOrder::LargestFirst && a.size != b.size) return a.size > b.size;
+        return a.path < b.path;
+    });
+}
+
+// Finds obj files in a folder and its subfolders without holding up the caller. A walker thread
+// queues the files as it finds them, one worker per hardware thread stats and counts each with the
+// SIMD vertex counter, and next() hands files over as soon as they are counted, so loading can start
+// while the scan is still going.
+class ObjFolderScanner
+{
+private:
+    ParseKernels kernels;
+    ObjScanOptions options;
+    bool compressed = false;
+
+    std::thread walker;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::string> pending;
+    std::deque<ScannedObjFile> counted;
+    std::vector<ScannedObjFile> scanned;
+    bool walked = false;
+    bool finished = false;
+
+    void walk(const std::string& folderPath)
+    {
+        TRACE_THREAD_NAME("scan walker");
+
+        size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threadCount; ++t)
+        {
+            workers.emplace_back([this, t]() { count(t); });
+        }
+
         {
-            result.push_back(folderPath + "\\" + filename);
+            TRACE_SCOPE("scan", "walk", folderPath);
+
+            forEachObjFile(folderPath, compressed, options, [this](std::string path)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.push_back(std::move(path));
+                changed.notify_all();
+            });
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            walked = true;
+            changed.notify_all();
         }
 
-        std::string fullPath = folderPath + "\\" + filename;
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
 
-        size_t vertexCount = CountVerticesInObj(fullPath);
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        changed.notify_all();
+    }
 
-        std::cout << filename << " -> " << vertexCount << " vertices\n";
+    void count(size_t thread)
+    {
+        TRACE_THREAD_NAME("scan worker " + std::to_string(thread));
+        (void)thread; // only used for the trace name
 
-    } while (FindNextFileA(handle, &findData));
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            changed.wait(lock, [this]() { return !pending.empty() || walked; });
+            if (pending.empty()) return;
 
-    FindClose(handle);
+            ScannedObjFile file;
+            file.path = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+
+            bool allowed;
+            {
+                TRACE_SCOPE("scan", "count", file.path);
+
+                std::error_code error;
+                file.size = std::filesystem::file_size(file.path, error);
+                if (error) file.size = 0;
+
+                // Files outside the size limits are dropped before anything reads them.
+                allowed = options.sizeAllowed(file.size);
+                if (allowed) file.vertexCount = countObjVertices(file.path, kernels);
+            }
+
+            lock.lock();
+            if (allowed)
+            {
+                counted.push_back(file);
+                scanned.push_back(std::move(file));
+                changed.notify_all();
+            }
+        }
+    }
+
+public:
+    ObjFolderScanner(const ObjScanOptions& options = ObjScanOptions()) : kernels(selectParseKernels(kernelIsa)), options(options)
+    {
+    }
+
+    ~ObjFolderScanner()
+    {
+        if (walker.joinable()) walker.join();
+    }
+
+    // With compressed set, finds the .obj.gz (and .obj.zst when supported) files instead of plain objs.
+    bool start(const std::string& folderPath, bool compressedFiles = false)
+    {
+        compressed = compressedFiles;
+
+        std::error_code error;
+        if (!std::filesystem::is_directory(folderPath, error))
+        {
+            std::cout << "Folder not found: " << folderPath << std::endl;
+            walked = finished = true;
+            return false;
+        }
+
+        walker = std::thread([this, folderPath]() { walk(folderPath); });
+        return true;
+    }
+
+    // Waits for the next counted file, in whatever order the workers finish. False once every file
+    // has been handed over.
+    bool next(ScannedObjFile& file)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return !counted.empty() || finished; });
+        if (counted.empty()) return false;
+
+        file = std::move(counted.front());
+        counted.pop_front();
+        return true;
+    }
+
+    // Waits for the scan to finish and returns every file it found in the options' order.
+    std::vector<ScannedObjFile> wait()
+    {
+        if (walker.joinable()) walker.join();
+
+        std::vector<ScannedObjFile> files = scanned;
+        sortScannedFiles(files, options.order);
+        return files;
+    }
+};
+
+// With compressed set, returns the .obj.gz (and .obj.zst when supported) files instead of plain objs.
+std::vector<std::string> scanFolderForObjFiles(const std::string& folderPath, bool compressed = false, const ObjScanOptions& options = ObjScanOptions())
+{
+    std::vector<std::string> result;
+
+    ObjFolderScanner scanner(options);
+    scanner.start(folderPath, compressed);
+
+    for (const ScannedObjFile& file : scanner.wait())
+    {
+        std::cout << file.path << " -> " << file.vertexCount << " vertices\n";
+        result.push_back(file.path);
+    }
 
     return result;
-}
\ No newline at end of file
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "../types.h"
+#include "traceEvents.h"
+
+#include <thread>
+
+// Splits [0, count) into one contiguous range per hardware thread and calls function(begin, end) on each.
+// Work smaller than minBatch per thread runs inline on the calling thread.
+template <typename Function>
+void parallelFor(size_t count, size_t minBatch, Function function)
+{
+    size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, std::max<size_t>(1, count / std::max<size_t>(1, minBatch)));
+
+    if (threadCount <= 1)
+    {
+        TRACE_SCOPE("chunk", "parallelFor chunk", "0-" + std::to_string(count));
+        function((size_t)0, count);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount - 1);
+
+    size_t batch = (count + threadCount - 1) / threadCount;
+
+    for (size_t t = 1; t < threadCount; ++t)
+    {
+        size_t begin = std::min(count, t * batch);
+        size_t end = std::min(count, begin + batch);
+        workers.emplace_back([&function, begin, end]()
+        {
+            TRACE_SCOPE("chunk", "parallelFor chunk", std::to_string(begin) + "-" + std::to_string(end));
+            function(begin, end);
+        });
+    }
+
+    {
+        TRACE_SCOPE("chunk", "parallelFor chunk", "0-" + std::to_string(std::min(count, batch)));
+        function((size_t)0, std::min(count, batch));
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include "../types.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#pragma region Helper functions
+static const char* perfCounterName(PerfCounter counter)
+{
+    switch (counter)
+    {
+        case PerfCounter::Cycles: return "cycles";
+        case PerfCounter::Instructions: return "instructions";
+        case PerfCounter::BranchMisses: return "branch misses";
+        case PerfCounter::L1dMisses: return "L1d misses";
+        case PerfCounter::LlcMisses: return "LLC misses";
+        case PerfCounter::DtlbMisses: return "dTLB misses";
+        default: return "unknown";
+    }
+}
+
+#ifdef __linux__
+static int openPerfCounter(PerfCounter counter)
+{
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.inherit = 1; // threads the load starts, such as the mtl parser, count too
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    auto cacheMiss = [](uint64_t cache)
+    {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+
+    switch (counter)
+    {
+        case PerfCounter::Cycles: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case PerfCounter::Instructions: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case PerfCounter::BranchMisses: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case PerfCounter::L1dMisses: attr.type = PERF_TYPE_HW_CACHE; attr.config = cacheMiss(PERF_COUNT_HW_CACHE_L1D); break;
+        case PerfCounter::LlcMisses: attr.type = PERF_TYPE_HW_CACHE; attr.config = cacheMiss(PERF_COUNT_HW_CACHE_LL); break;
+        case PerfCounter::DtlbMisses: attr.type = PERF_TYPE_HW_CACHE; attr.config = cacheMiss(PERF_COUNT_HW_CACHE_DTLB); break;
+        default: return -1;
+    }
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+#pragma endregion
+
+// Hardware counters for the calling thread and the threads it starts, opened once per loader run and
+// read around every load. Counters the CPU, kernel or permissions do not allow are skipped; when none
+// open, or the session is disabled, every load reports nothing and the summary leaves the counter
+// metrics out. Counters that were multiplexed with others are scaled up to the full time the load ran.
+class PerfCounterSession
+{
+private:
+    int fds[(size_t)PerfCounter::Count];
+    size_t openCount = 0;
+
+public:
+    explicit PerfCounterSession(bool enabled)
+    {
+        for (size_t c = 0; c < (size_t)PerfCounter::Count; ++c)
+        {
+#ifdef __linux__
+            fds[c] = enabled ? openPerfCounter((PerfCounter)c) : -1;
+#else
+            fds[c] = -1;
+#endif
+            openCount += fds[c] >= 0;
+        }
+
+        if (!enabled) return;
+
+        static bool reported = false;
+        if (openCount < (size_t)PerfCounter::Count && !reported)
+        {
+            reported = true;
+            std::cout << "Hardware counters unavailable:";
+            for (size_t c = 0; c < (size_t)PerfCounter::Count; ++c)
+            {
+                if (fds[c] < 0) std::cout << " " << perfCounterName((PerfCounter)c);
+            }
+            std::cout << "\n";
+        }
+    }
+
+    ~PerfCounterSession()
+    {
+#ifdef __linux__
+        for (int fd : fds)
+        {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    PerfCounterSession(const PerfCounterSession&) = delete;
+    PerfCounterSession& operator=(const PerfCounterSession&) = delete;
+
+    bool available() const
+    {
+        return openCount > 0;
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        for (int fd : fds)
+        {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    PerfCounterValues stop()
+    {
+        PerfCounterValues result;
+
+#ifdef __linux__
+        for (int fd : fds)
+        {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+
+        for (size_t c = 0; c < (size_t)PerfCounter::Count; ++c)
+        {
+            uint64_t data[3]; // value, time enabled, time running
+            if (fds[c] < 0 || read(fds[c], data, sizeof(data)) != (ssize_t)sizeof(data) || data[2] == 0) continue;
+
+            result.values[c] = data[2] < data[1] ? (uint64_t)((double)data[0] * data[1] / data[2]) : data[0];
+            result.valid[c] = true;
+        }
+#endif
+
+        return result;
+    }
+};
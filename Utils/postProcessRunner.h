@@ -0,0 +1,97 @@
+#pragma once
+#include <map>
+
+#include "../types.h"
+
+#include "../PostProcess/post_process_template.h"
+#include "../PostProcess/normals.h"
+#include "../PostProcess/vertex_cache.h"
+#include "../PostProcess/meshlets.h"
+#include "../PostProcess/tangents.h"
+#include "../PostProcess/quantize.h"
+#include "../PostProcess/compression.h"
+
+#include "syntheticMeshes.h"
+
+std::vector<PostProcessTemplate*>& GetPostProcessRegistry()
+{
+	static std::vector<PostProcessTemplate*> registry;
+	return registry;
+}
+
+struct PostProcessRegistrar
+{
+	PostProcessRegistrar(PostProcessTemplate* instance)
+	{
+		GetPostProcessRegistry().push_back(instance);
+	}
+};
+
+// Stages run in registration order on every loaded mesh; comment a stage out to skip it.
+static NormalGenerator normalGeneratorStage(NormalWeighting::Area);
+static PostProcessRegistrar registerStageA(&normalGeneratorStage);
+
+static VertexCacheOptimizer vertexCacheOptimizerStage;
+static PostProcessRegistrar registerStageB(&vertexCacheOptimizerStage);
+
+static MeshletBuilder meshletBuilderStage(64, 124);
+static PostProcessRegistrar registerStageC(&meshletBuilderStage);
+
+static TangentGenerator tangentGeneratorStage;
+static PostProcessRegistrar registerStageD(&tangentGeneratorStage);
+
+static VertexQuantizer halfVertexStage(CompactVertexFormat::Half);
+static PostProcessRegistrar registerStageE(&halfVertexStage);
+
+static VertexQuantizer quantizedVertexStage(CompactVertexFormat::Quantized);
+static PostProcessRegistrar registerStageF(&quantizedVertexStage);
+
+static MeshCompressor meshCompressorStage;
+static PostProcessRegistrar registerStageG(&meshCompressorStage);
+
+void runPostProcessing(std::vector<Result>& results)
+{
+	// Stages rewrite indices in place, so they work on the 32 bit copy and the result is packed again.
+	for (Result& r : results)
+	{
+		r.mesh.unpackIndices();
+	}
+
+	for (PostProcessTemplate* stage : GetPostProcessRegistry())
+	{
+		for (Result& r : results)
+		{
+			r.stages.push_back(stage->process(r.mesh));
+		}
+
+		std::cout << "Post-processed with: " << stage->Name() << "\n";
+	}
+
+	if (compactIndexBuffers)
+	{
+		for (Result& r : results)
+		{
+			r.mesh.packIndices();
+		}
+	}
+};
+
+// Runs the registered stages on generated meshes that are far bigger than the sample objs.
+std::vector<Results> runSyntheticPostProcessing(unsigned int resolution)
+{
+	// Results only points at its name, so each resolution's label is kept for the rest of the run.
+	static std::map<unsigned int, std::string> names;
+	std::string& name = names[resolution];
+	name = "synthetic grid " + std::to_string(resolution) + "x" + std::to_string(resolution);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	Mesh mesh = generateSyntheticGrid(resolution);
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	std::vector<Results> results{};
+	results.push_back({ name.c_str(), { { mesh, duration } } });
+	runPostProcessing(results.back().data);
+
+	return results;
+};
\ No newline at end of file
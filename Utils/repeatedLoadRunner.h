@@ -0,0 +1,72 @@
+#pragma once
+#include "../types.h"
+
+#include "../Implementations/memory_cache.h"
+#include "traceEvents.h"
+
+#include <thread>
+
+// Simulates a service asking for the same files over and over from several threads: every thread
+// requests every path `repeats` times. Run once against the loader directly and once through the
+// in-memory cache so the two totals can be compared.
+std::vector<Results> runRepeatedLoads(LoaderTemplate* loader, const std::vector<std::string>& paths, size_t threadCount, size_t repeats)
+{
+    static std::string directName = std::string(loader->Name()) + " (direct, repeated)";
+    static std::string cachedName = std::string(loader->Name()) + " (in-memory cache, repeated)";
+
+    std::vector<Results> results{};
+    size_t requests = threadCount * repeats * paths.size();
+
+    // The direct loader is not reentrant, so the baseline is the same request count on one thread.
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < threadCount * repeats; ++i)
+    {
+        for (const std::string& path : paths)
+        {
+            Mesh mesh = loader->loadObjImplementation(path);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double directMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    results.push_back({ directName.c_str(), {}, { { "Requests", (double)requests }, { "Total time ms", directMs },
+        { "Avg request latency us", 1000.0 * directMs / requests } } });
+
+    MeshMemoryCache cache(loader);
+    std::vector<std::thread> workers;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t t = 0; t < threadCount; ++t)
+    {
+        workers.emplace_back([&cache, &paths, repeats, t]()
+        {
+            TRACE_THREAD_NAME("repeated load worker " + std::to_string(t));
+
+            for (size_t r = 0; r < repeats; ++r)
+            {
+                // Start each thread on a different file so first requests overlap on the same paths.
+                for (size_t i = 0; i < paths.size(); ++i)
+                {
+                    TRACE_SCOPE("request", "cache get", paths[(i + t) % paths.size()]);
+                    std::shared_ptr<const Mesh> mesh = cache.get(paths[(i + t) % paths.size()]);
+                }
+            }
+        });
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double cachedMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    MetricList metrics = { { "Requests", (double)requests }, { "Total time ms", cachedMs },
+        { "Avg request latency us", 1000.0 * cachedMs / requests } };
+    MetricList cacheMetrics = cache.Metrics();
+    metrics.insert(metrics.end(), cacheMetrics.begin(), cacheMetrics.end());
+
+    results.push_back({ cachedName.c_str(), {}, metrics });
+
+    return results;
+};
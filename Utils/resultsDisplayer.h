@@ -1,6 +1,40 @@
 #pragma once
 #include "../types.h"
 
+std::vector<StageSummary> getStageSummaries(const std::vector<Result>& data)
+{
+    std::vector<StageSummary> stages;
+
+    for (const Result& r : data)
+    {
+        for (size_t s = 0; s < r.stages.size(); ++s)
+        {
+            const StageResult& stage = r.stages[s];
+
+            if (s >= stages.size())
+            {
+                stages.push_back({ stage.stageName, std::chrono::microseconds(0), 0, {} });
+            }
+
+            StageSummary& summary = stages[s];
+            summary.totalTime += stage.elapsed;
+            summary.totalBytes += stage.bytesProcessed;
+
+            for (size_t m = 0; m < stage.metrics.size(); ++m)
+            {
+                if (m >= summary.averageMetrics.size())
+                {
+                    summary.averageMetrics.push_back({ stage.metrics[m].first, 0.0 });
+                }
+
+                summary.averageMetrics[m].second += stage.metrics[m].second / data.size();
+            }
+        }
+    }
+
+    return stages;
+}
+
 std::vector<ImplSummary> getSummaries(std::vector<Results> results)
 {
     std::vector<ImplSummary> summaries;
@@ -10,16 +44,81 @@ std::vector<ImplSummary> getSummaries(std::vector<Results> results)
     {
         size_t totalVertices = 0;
         size_t totalIndices = 0;
+        size_t indexBytes = 0;
+        size_t compactMeshes = 0;
+        size_t submeshes = 0;
+        size_t materials = 0;
         std::chrono::milliseconds totalTime(0);
+        PhaseTimes phases;
+        PerfCounterValues counters;
+        size_t inputBytes = 0;
+        MemoryUsage memory;
 
         for (const Result& r : implResults.data)
         {
             totalVertices += r.mesh.vertices.size();
-            totalIndices += r.mesh.indices.size();
+            totalIndices += r.mesh.indexCount();
+            indexBytes += r.mesh.indexBytes();
+            compactMeshes += r.mesh.has16BitIndices();
+            submeshes += r.mesh.submeshes.size();
+            materials += r.mesh.materials ? r.mesh.materials->materials.size() : 0;
             totalTime += r.elapsed;
+            phases.add(r.phases);
+            counters.add(r.counters);
+            inputBytes += r.inputBytes;
+            memory.add(r.memory);
+        }
+
+        MetricList metrics = implResults.metrics;
+
+        if (submeshes > 0)
+        {
+            metrics.push_back({ "Submeshes", (double)submeshes });
+        }
+
+        if (materials > 0)
+        {
+            metrics.push_back({ "Materials", (double)materials });
+        }
+
+        if (counters.has(PerfCounter::Cycles) && counters.get(PerfCounter::Cycles) > 0)
+        {
+            double cycles = counters.get(PerfCounter::Cycles);
+            double kilobytes = inputBytes / 1024.0;
+
+            if (counters.has(PerfCounter::Instructions)) metrics.push_back({ "IPC", counters.get(PerfCounter::Instructions) / cycles });
+            metrics.push_back({ "Input bytes per cycle", inputBytes / cycles });
+
+            const std::pair<PerfCounter, const char*> perKilobyte[] = {
+                { PerfCounter::BranchMisses, "Branch misses per KB" },
+                { PerfCounter::L1dMisses, "L1d misses per KB" },
+                { PerfCounter::LlcMisses, "LLC misses per KB" },
+                { PerfCounter::DtlbMisses, "dTLB misses per KB" }
+            };
+
+            for (const auto& counter : perKilobyte)
+            {
+                if (counters.has(counter.first) && kilobytes > 0) metrics.push_back({ counter.second, counters.get(counter.first) / kilobytes });
+            }
+        }
+
+        if (memory.allocations > 0)
+        {
+            metrics.push_back({ "Allocations", (double)memory.allocations });
+            metrics.push_back({ "Allocated MB", memory.allocatedBytes / (1024.0 * 1024.0) });
+            metrics.push_back({ "Peak heap MB", memory.peakHeapBytes / (1024.0 * 1024.0) });
         }
 
-        summaries.push_back({ implResults.implementationName, totalVertices, totalIndices, totalTime });
+        if (compactIndexBuffers && !implResults.data.empty())
+        {
+            double wideBytes = (double)totalIndices * sizeof(unsigned int);
+
+            metrics.push_back({ "Meshes with 16-bit indices", (double)compactMeshes });
+            metrics.push_back({ "Index memory saved KB", (wideBytes - indexBytes) / 1024.0 });
+            metrics.push_back({ "Index memory saved %", wideBytes > 0 ? 100.0 * (wideBytes - indexBytes) / wideBytes : 0.0 });
+        }
+
+        summaries.push_back({ implResults.implementationName, totalVertices, totalIndices, totalTime, getStageSummaries(implResults.data), metrics, phases });
     }
 
     return summaries;
@@ -33,26 +132,85 @@ void sortSummaries(std::vector<ImplSummary> &summaries)
         });
 }
 
+void displayStageSummary(const StageSummary& stage)
+{
+    double seconds = stage.totalTime.count() / 1e6;
+    double throughput = seconds > 0 ? (stage.totalBytes / (1024.0 * 1024.0)) / seconds : 0.0;
+
+    std::cout << "   - " << stage.name << ": " << std::fixed << std::setprecision(3)
+        << stage.totalTime.count() / 1000.0 << " ms, " << std::setprecision(1) << throughput << " MB/s";
+
+    for (const auto& metric : stage.averageMetrics)
+    {
+        std::cout << ", " << metric.first << ": " << std::setprecision(3) << metric.second;
+    }
+
+    std::cout << "\n" << std::defaultfloat;
+}
+
+// One line with every phase the loader reported, in load order.
+void displayPhaseTimes(const PhaseTimes& phases)
+{
+    bool any = false;
+
+    for (size_t p = 0; p < (size_t)LoadPhase::Count; ++p)
+    {
+        if (phases.elapsed[p].count() == 0) continue;
+
+        std::cout << (any ? ", " : "   Phases: ") << loadPhaseName((LoadPhase)p) << " " << std::fixed << std::setprecision(3)
+            << phases.elapsed[p].count() / 1e6 << " ms" << std::defaultfloat;
+        any = true;
+    }
+
+    if (any) std::cout << "\n";
+}
+
+// Console colors by their Windows attribute; elsewhere the matching ANSI color when stdout is a terminal.
+void setConsoleColor(unsigned short color)
+{
+#ifdef _WIN32
+    SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), color);
+#else
+    if (!isatty(STDOUT_FILENO)) return;
+
+    static const char* ansi[] = { "30", "34", "32", "36", "31", "35", "33", "0" };
+    std::cout << "\033[" << (color < 8 ? ansi[color] : "0") << "m";
+#endif
+}
+
 void displaySummaries(std::vector<ImplSummary> summaries)
 {
     std::cout << "===== Benchmark Summary =====\n\n";
 
-    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-    std::vector<WORD> colors = { 3, 2, 6, 4, 7 };
+    std::vector<unsigned short> colors = { 3, 2, 6, 4, 7 };
 
     for (size_t i = 0; i < summaries.size(); ++i)
     {
-        WORD color = (i < colors.size()) ? colors[i] : 7;
+        unsigned short color = (i < colors.size()) ? colors[i] : 7;
 
-        SetConsoleTextAttribute(hConsole, color);
+        setConsoleColor(color);
 
         std::cout << i + 1 << ". " << summaries[i].name << "\n";
         std::cout << "   Total Vertices: " << summaries[i].totalVertices
             << ", Total Indices: " << summaries[i].totalIndices
-            << ", Total Time: " << summaries[i].totalTime.count() << " ms\n\n";
+            << ", Total Time: " << summaries[i].totalTime.count() << " ms\n";
+
+        displayPhaseTimes(summaries[i].phases);
+
+        for (const auto& metric : summaries[i].metrics)
+        {
+            std::cout << "   " << metric.first << ": " << std::fixed << std::setprecision(2) << metric.second << std::defaultfloat << "\n";
+        }
+
+        for (const StageSummary& stage : summaries[i].stages)
+        {
+            displayStageSummary(stage);
+        }
+
+        std::cout << "\n";
     }
 
-    SetConsoleTextAttribute(hConsole, 7);
+    setConsoleColor(7);
 }
 
 void showResults(std::vector<Results> results)
@@ -62,4 +220,125 @@ void showResults(std::vector<Results> results)
     sortSummaries(summaries);
 
     displaySummaries(summaries);
-};
\ No newline at end of file
+};
+
+#pragma region Helper functions
+// Sum of every file's heap peak over the input size, so loaders that read different formats compare.
+static double peakHeapPerInputMB(const Results& results)
+{
+    size_t peak = 0, input = 0;
+    for (const Result& r : results.data)
+    {
+        peak += r.memory.peakHeapBytes;
+        input += r.inputBytes;
+    }
+
+    return input > 0 ? (double)peak / input : 0.0;
+}
+#pragma endregion
+
+// Loaders ranked by heap peak per MB of input, each followed by its files. RSS growth only shows for
+// loads that pushed the process past its earlier high-water mark, so it is mostly the first large ones.
+void showMemoryResults(std::vector<Results> results)
+{
+    std::cout << "===== Memory Per Loader =====\n\n";
+
+    std::stable_sort(results.begin(), results.end(),
+        [](const Results& a, const Results& b) {
+            return peakHeapPerInputMB(a) < peakHeapPerInputMB(b);
+        });
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        MemoryUsage total;
+        for (const Result& r : results[i].data)
+        {
+            total.add(r.memory);
+        }
+
+        std::cout << i + 1 << ". " << results[i].implementationName << "\n" << std::fixed << std::setprecision(2)
+            << "   Peak heap MB per input MB: " << peakHeapPerInputMB(results[i])
+            << ", Allocations: " << total.allocations
+            << ", Allocated MB: " << total.allocatedBytes / (1024.0 * 1024.0)
+            << ", Freed MB: " << total.freedBytes / (1024.0 * 1024.0)
+            << ", Peak RSS growth MB: " << total.peakRssGrowth / (1024.0 * 1024.0) << "\n";
+
+        for (const Result& r : results[i].data)
+        {
+            std::cout << "   - " << r.path << ": peak heap KB " << r.memory.peakHeapBytes / 1024.0
+                << ", allocations " << r.memory.allocations
+                << ", allocated KB " << r.memory.allocatedBytes / 1024.0
+                << ", freed KB " << r.memory.freedBytes / 1024.0
+                << ", peak RSS growth KB " << r.memory.peakRssGrowth / 1024.0 << "\n";
+        }
+
+        std::cout << std::defaultfloat << "\n";
+    }
+};
+
+void showSyntheticResults(std::vector<Results> results)
+{
+    std::cout << "===== Synthetic Post-Processing =====\n\n";
+
+    for (const ImplSummary& summary : getSummaries(results))
+    {
+        std::cout << summary.name << "\n";
+        std::cout << "   Total Vertices: " << summary.totalVertices
+            << ", Total Indices: " << summary.totalIndices
+            << ", Generation Time: " << summary.totalTime.count() << " ms\n";
+
+        for (const StageSummary& stage : summary.stages)
+        {
+            displayStageSummary(stage);
+        }
+
+        std::cout << "\n";
+    }
+};
+
+void showMetricResults(const char* title, std::vector<Results> results)
+{
+    std::cout << "===== " << title << " =====\n\n";
+
+    for (const Results& r : results)
+    {
+        std::cout << r.implementationName << "\n";
+
+        for (const auto& metric : r.metrics)
+        {
+            std::cout << "   " << metric.first << ": " << std::fixed << std::setprecision(2) << metric.second << std::defaultfloat << "\n";
+        }
+
+        std::cout << "\n";
+    }
+};
+
+void showRepeatedLoadResults(std::vector<Results> results)
+{
+    showMetricResults("Repeated Load Benchmark", results);
+};
+
+void showCompressedInputResults(std::vector<Results> results)
+{
+    showMetricResults("Compressed Input", results);
+};
+
+void showExportResults(std::vector<Results> results)
+{
+    showMetricResults("Export Benchmark", results);
+};
+
+void showMaterialResults(std::vector<Results> results)
+{
+    showMetricResults("Material Libraries", results);
+};
+
+void showKernelResults(std::vector<Results> results)
+{
+    showMetricResults("Parse Kernels", results);
+};
+
+void showScanResults(std::vector<Results> results)
+{
+    showMetricResults("Folder Scan", results);
+};
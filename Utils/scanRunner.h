@@ -0,0 +1,156 @@
+#pragma once
+#include "../types.h"
+
+#include "objFileScanner.h"
+#include "../Implementations/new_fast.h"
+
+#include <atomic>
+
+#pragma region Helper functions
+// Loads every file once with threadCount NewFast loaders that each take the next file in order, and
+// returns the time until all are done. idlePercent is the share of that time the threads spent
+// waiting for the last ones to finish.
+static double batchLoad(const std::vector<ScannedObjFile>& files, size_t threadCount, double& idlePercent)
+{
+    std::atomic<size_t> nextFile(0);
+    std::vector<double> busyMs(threadCount, 0.0);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t t = 0; t < threadCount; ++t)
+    {
+        workers.emplace_back([&files, &nextFile, &busyMs, &start, t]()
+        {
+            TRACE_THREAD_NAME("batch load worker " + std::to_string(t));
+
+            NewFast loader;
+            for (size_t i = nextFile++; i < files.size(); i = nextFile++)
+            {
+                TRACE_SCOPE("load", loader.Name(), files[i].path);
+                Mesh mesh = loader.loadObjImplementation(files[i].path);
+            }
+            busyMs[t] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        });
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double totalMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    double busy = 0.0;
+    for (double ms : busyMs) busy += ms;
+    idlePercent = totalMs > 0 ? 100.0 * (1.0 - busy / (totalMs * threadCount)) : 0.0;
+
+    return totalMs;
+}
+#pragma endregion
+
+// Scans the obj folder the old way and with ObjFolderScanner, then loads every file once after the
+// scan and once while it is still running, to show how much of the scan the loads can hide. Last,
+// batch loads on several threads compare path order with largest-first order.
+std::vector<Results> runFolderScans(LoaderTemplate* loader, const std::string& folderPath, size_t threadCount)
+{
+    static std::string serialName = "serial scan (ifstream, byte loop)";
+    static std::string parallelName = std::string("parallel scan (") + kernelIsaName(selectParseKernels(kernelIsa).isa) + " counter)";
+    static std::string thenLoadName = std::string("parallel scan, then ") + loader->Name();
+    static std::string overlappedName = std::string("parallel scan overlapped with ") + loader->Name();
+    static std::string pathOrderName = "batch load, path order";
+    static std::string largestFirstName = "batch load, largest first";
+
+    ObjScanOptions options;
+
+    std::vector<Results> results{};
+
+    size_t files = 0;
+    size_t vertices = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    forEachObjFile(folderPath, false, options, [&](const std::string& path)
+    {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(path, error);
+        if (error || !options.sizeAllowed(size)) return;
+
+        vertices += CountVerticesInObj(path);
+        ++files;
+    });
+    auto end = std::chrono::high_resolution_clock::now();
+    double serialMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    results.push_back({ serialName.c_str(), {}, { { "Files", (double)files }, { "Vertices", (double)vertices },
+        { "Scan time ms", serialMs } } });
+
+    files = vertices = 0;
+    start = std::chrono::high_resolution_clock::now();
+    {
+        ObjFolderScanner scanner(options);
+        scanner.start(folderPath);
+        for (const ScannedObjFile& file : scanner.wait())
+        {
+            vertices += file.vertexCount;
+            ++files;
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double parallelMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    results.push_back({ parallelName.c_str(), {}, { { "Files", (double)files }, { "Vertices", (double)vertices },
+        { "Scan time ms", parallelMs }, { "Speedup over serial", parallelMs > 0 ? serialMs / parallelMs : 0.0 } } });
+
+    // First mesh and total time, both from the start of the scan.
+    double firstMs = 0.0;
+    start = std::chrono::high_resolution_clock::now();
+    {
+        ObjFolderScanner scanner(options);
+        scanner.start(folderPath);
+        for (const ScannedObjFile& file : scanner.wait())
+        {
+            Mesh mesh = loader->loadObjImplementation(file.path);
+            if (firstMs == 0.0) firstMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double thenLoadMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    results.push_back({ thenLoadName.c_str(), {}, { { "Time to first mesh ms", firstMs }, { "Total time ms", thenLoadMs } } });
+
+    firstMs = 0.0;
+    start = std::chrono::high_resolution_clock::now();
+    {
+        ObjFolderScanner scanner(options);
+        scanner.start(folderPath);
+
+        ScannedObjFile file;
+        while (scanner.next(file))
+        {
+            Mesh mesh = loader->loadObjImplementation(file.path);
+            if (firstMs == 0.0) firstMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double overlappedMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    results.push_back({ overlappedName.c_str(), {}, { { "Time to first mesh ms", firstMs }, { "Total time ms", overlappedMs } } });
+
+    ObjFolderScanner scanner(options);
+    scanner.start(folderPath);
+    std::vector<ScannedObjFile> scanned = scanner.wait();
+
+    double idlePercent;
+    sortScannedFiles(scanned, ScanOrder::Path);
+    double pathOrderMs = batchLoad(scanned, threadCount, idlePercent);
+
+    results.push_back({ pathOrderName.c_str(), {}, { { "Threads", (double)threadCount }, { "Total time ms", pathOrderMs },
+        { "Idle thread time %", idlePercent } } });
+
+    sortScannedFiles(scanned, ScanOrder::LargestFirst);
+    double largestFirstMs = batchLoad(scanned, threadCount, idlePercent);
+
+    results.push_back({ largestFirstName.c_str(), {}, { { "Threads", (double)threadCount }, { "Total time ms", largestFirstMs },
+        { "Idle thread time %", idlePercent }, { "Speedup over path order", largestFirstMs > 0 ? pathOrderMs / largestFirstMs : 0.0 } } });
+
+    return results;
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include "../types.h"
+
+#include <filesystem>
+
+// Displaced, uv mapped grid of resolution x resolution quads. Normals are left at zero so the
+// normal stage has work to do, and the wavy surface keeps tangent frames non-trivial.
+Mesh generateSyntheticGrid(unsigned int resolution)
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+
+    unsigned int side = resolution + 1;
+    vertices.reserve((size_t)side * side);
+    indices.reserve((size_t)resolution * resolution * 6);
+
+    for (unsigned int y = 0; y < side; ++y)
+    {
+        for (unsigned int x = 0; x < side; ++x)
+        {
+            float u = (float)x / resolution;
+            float v = (float)y / resolution;
+            float height = 0.05f * std::sin(u * 40.0f) * std::cos(v * 30.0f);
+
+            vertices.emplace_back(vec3(u * 2.0f - 1.0f, height, v * 2.0f - 1.0f), vec2(u, v));
+        }
+    }
+
+    for (unsigned int y = 0; y < resolution; ++y)
+    {
+        for (unsigned int x = 0; x < resolution; ++x)
+        {
+            unsigned int i = y * side + x;
+
+            indices.push_back(i);
+            indices.push_back(i + side);
+            indices.push_back(i + 1);
+
+            indices.push_back(i + 1);
+            indices.push_back(i + side);
+            indices.push_back(i + side + 1);
+        }
+    }
+
+    return Mesh(vertices, indices);
+}
+
+// Rows of alternating five pointed stars (concave 10-gons) and hexagons (convex 6-gons) in the y = 0
+// plane, as obj text, so the loaders' triangulation has both kinds of face to handle.
+std::string generateSyntheticNgonObj(unsigned int faceCount)
+{
+    const float pi = 3.14159265f;
+    const unsigned int facesPerRow = 60;
+    const float spacing = 3.0f;
+
+    std::ostringstream obj;
+    obj << std::fixed << std::setprecision(4);
+    obj << "# Concave (star) and convex (hexagon) n-gons for triangulation checks\n\n";
+
+    for (unsigned int f = 0; f < faceCount; ++f)
+    {
+        bool star = f % 2 == 0;
+        unsigned int corners = star ? 10 : 6;
+        float centerX = (f % facesPerRow) * spacing;
+        float centerZ = (f / facesPerRow) * spacing;
+
+        for (unsigned int c = 0; c < corners; ++c)
+        {
+            float angle = -2.0f * pi * c / corners;
+            float radius = (star && c % 2 == 1) ? 0.5f : 1.2f;
+            obj << "v " << centerX + radius * std::cos(angle) << " 0 " << centerZ + radius * std::sin(angle) << "\n";
+        }
+    }
+
+    obj << "\n";
+
+    unsigned int next = 1;
+    for (unsigned int f = 0; f < faceCount; ++f)
+    {
+        unsigned int corners = f % 2 == 0 ? 10 : 6;
+
+        obj << "f";
+        for (unsigned int c = 0; c < corners; ++c) obj << " " << next++;
+        obj << "\n";
+    }
+
+    return obj.str();
+}
+
+// Writes the n-gon obj into folderPath and returns its path, empty when it could not be written.
+std::string writeSyntheticNgonObj(const std::string& folderPath, unsigned int faceCount)
+{
+    std::error_code error;
+    std::filesystem::create_directories(folderPath, error);
+
+    std::string path = folderPath + pathSeparator + "ngons.obj";
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << generateSyntheticNgonObj(faceCount);
+    out.close();
+
+    return out ? path : std::string();
+}
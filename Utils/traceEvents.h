@@ -0,0 +1,165 @@
+#pragma once
+#include "../types.h"
+
+// Chrome trace-event recording, viewable in Perfetto or chrome://tracing. Only built with OBJ_WITH_TRACE;
+// without it the TRACE_ macros expand to nothing, so loaders keep their instrumentation in every build.
+#ifdef OBJ_WITH_TRACE
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+
+struct TraceEvent
+{
+    std::string name;
+    const char* category;
+    std::string detail;
+    double start; // microseconds since the recorder started
+    double duration;
+    unsigned int thread;
+};
+
+// Collects complete events from every thread. Each event takes the lock once when it ends; the
+// instrumented scopes are files, phases and worker chunks, never single lines, so that stays cheap.
+class TraceRecorder
+{
+private:
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::vector<std::pair<unsigned int, std::string>> threadNames;
+    std::atomic<unsigned int> nextThread{ 0 };
+    std::chrono::high_resolution_clock::time_point origin = std::chrono::high_resolution_clock::now();
+
+public:
+    static TraceRecorder& instance()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    // The same clock the phase timers read, so their time points convert directly.
+    double since(std::chrono::high_resolution_clock::time_point time) const
+    {
+        return std::chrono::duration<double, std::micro>(time - origin).count();
+    }
+
+    double now() const
+    {
+        return since(std::chrono::high_resolution_clock::now());
+    }
+
+    // Small stable ids read better in the viewer than native thread ids.
+    unsigned int threadId()
+    {
+        static thread_local unsigned int id = nextThread++;
+        return id;
+    }
+
+    void nameThread(const std::string& name)
+    {
+        unsigned int id = threadId();
+        std::lock_guard<std::mutex> lock(mutex);
+        threadNames.emplace_back(id, name);
+    }
+
+    void add(TraceEvent event)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(std::move(event));
+    }
+
+    bool write(const std::string& path)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        auto escaped = [](const std::string& text)
+        {
+            std::string result;
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\') result += '\\';
+                if ((unsigned char)c >= 0x20) result += c;
+            }
+            return result;
+        };
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        file << "{\"traceEvents\":[\n";
+        bool first = true;
+
+        for (const auto& thread : threadNames)
+        {
+            file << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread.first
+                << ",\"args\":{\"name\":\"" << escaped(thread.second) << "\"}}";
+            first = false;
+        }
+
+        file.precision(3);
+        file << std::fixed;
+
+        for (const TraceEvent& event : events)
+        {
+            file << (first ? "" : ",\n") << "{\"ph\":\"X\",\"name\":\"" << escaped(event.name) << "\",\"cat\":\"" << event.category
+                << "\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start << ",\"dur\":" << event.duration;
+            if (!event.detail.empty()) file << ",\"args\":{\"detail\":\"" << escaped(event.detail) << "\"}";
+            file << "}";
+            first = false;
+        }
+
+        file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return (bool)file;
+    }
+};
+
+// One complete event from construction to the end of the scope.
+class TraceScope
+{
+private:
+    std::string name;
+    const char* category;
+    std::string detail;
+    double start;
+
+public:
+    TraceScope(const char* category, std::string name, std::string detail = std::string())
+        : name(std::move(name)), category(category), detail(std::move(detail)), start(TraceRecorder::instance().now()) {}
+
+    ~TraceScope()
+    {
+        TraceRecorder& recorder = TraceRecorder::instance();
+        double end = recorder.now();
+        recorder.add({ std::move(name), category, std::move(detail), start, end - start, recorder.threadId() });
+    }
+};
+
+// For events whose start and end are not a scope, e.g. the phases a PhaseSwitcher moves through.
+static inline void traceComplete(const char* category, const char* name, std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end)
+{
+    TraceRecorder& recorder = TraceRecorder::instance();
+    double begin = recorder.since(start);
+    recorder.add({ name, category, std::string(), begin, recorder.since(end) - begin, recorder.threadId() });
+}
+
+static inline void writeTraceFile(const std::string& path)
+{
+    if (TraceRecorder::instance().write(path)) std::cout << "Wrote trace to " << path << "\n";
+    else std::cout << "Failed to write trace " << path << "\n";
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(category, ...) TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, __VA_ARGS__)
+#define TRACE_COMPLETE(category, name, start, end) traceComplete(category, name, start, end)
+#define TRACE_THREAD_NAME(name) TraceRecorder::instance().nameThread(name)
+#define TRACE_WRITE(path) writeTraceFile(path)
+
+#else
+
+#define TRACE_SCOPE(category, ...) ((void)0)
+#define TRACE_COMPLETE(category, name, start, end) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#define TRACE_WRITE(path) ((void)0)
+
+#endif
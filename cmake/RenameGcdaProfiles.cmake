@@ -0,0 +1,18 @@
+# GCC stores a profile per object file, named after the object's path with '/' mangled to '#'. The
+# instrumented and the optimized benchmark compile the same sources into different target folders,
+# so the training profiles are copied to the names the optimized build looks for.
+#   cmake -DPGO_DATA_DIR=<dir> -DFROM=<instrumented>.dir -DTO=<optimized>.dir -P RenameGcdaProfiles.cmake
+
+file(GLOB profiles ${PGO_DATA_DIR}/*.gcda)
+
+if(NOT profiles)
+    message(FATAL_ERROR "No profiles in ${PGO_DATA_DIR}; did the training run finish?")
+endif()
+
+foreach(profile ${profiles})
+    get_filename_component(name ${profile} NAME)
+    string(REPLACE ${FROM} ${TO} renamed ${name})
+    if(NOT renamed STREQUAL name)
+        configure_file(${profile} ${PGO_DATA_DIR}/${renamed} COPYONLY)
+    endif()
+endforeach()
@@ -0,0 +1,17 @@
+# Runs one benchmark build in RUN_DIR with a fresh cache and converted files, so every build in a
+# comparison starts from the same state, and writes its report to OUTPUT.
+#   cmake -DBENCHMARK=<exe> -DRUN_DIR=<dir> -DOUTPUT=<file> -P RunBenchmark.cmake
+
+file(REMOVE_RECURSE ${RUN_DIR}/MeshCache ${RUN_DIR}/Interchange ${RUN_DIR}/Exported)
+
+execute_process(
+    COMMAND ${BENCHMARK}
+    WORKING_DIRECTORY ${RUN_DIR}
+    OUTPUT_FILE ${OUTPUT}
+    RESULT_VARIABLE result)
+
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${BENCHMARK} failed (${result}), see ${OUTPUT}")
+endif()
+
+message(STATUS "Wrote ${OUTPUT}")
@@ -12,9 +12,46 @@
 #include <unordered_map>
 #include <iomanip>
 #include <algorithm>
+#include <cstdint>
+#include <variant>
+#include <memory>
 
+#ifdef _WIN32
 #define NOMINMAX
 #include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Separator for the paths the benchmark builds itself.
+#ifdef _WIN32
+const char pathSeparator = '\\';
+#else
+const char pathSeparator = '/';
+#endif
+
+// One file name for a scanned path, so files from different subfolders stay apart when they are
+// written next to each other, e.g. Objs/props/box.obj -> Objs_props_box.obj.
+std::string flattenedFileName(const std::string& path)
+{
+    std::string name = path;
+    while (name.size() > 2 && name[0] == '.' && (name[1] == '/' || name[1] == '\\')) name.erase(0, 2);
+
+    for (char& c : name)
+    {
+        if (c == '/' || c == '\\' || c == ':') c = '_';
+    }
+    return name;
+}
+
+// SSE2 is baseline on x64; the SIMD paths fall back to scalar code everywhere else.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OBJ_SSE2 1
+#include <emmintrin.h>
+#endif
 
 void writeNewLine(const char* text)
 {
@@ -107,6 +144,23 @@ struct vec3
     }
 };
 
+struct vec4
+{
+    float x, y, z, w;
+
+    // Constructors
+    vec4() : x(0), y(0), z(0), w(0) {}
+    vec4(float v) : x(v), y(v), z(v), w(v) {}
+    vec4(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+    vec4(const vec3& v, float w_) : x(v.x), y(v.y), z(v.z), w(w_) {}
+
+    // Util functions
+    vec3 xyz() const
+    {
+        return { x, y, z };
+    }
+};
+
 struct Vertex
 {
 	vec3 pos;
@@ -175,11 +229,118 @@ struct Vertex
     {}
 };
 
+// Extended layout for normal mapping: tangent.xyz plus the bitangent sign in tangent.w.
+struct TangentVertex
+{
+    vec3 pos;
+    vec3 normals;
+    vec2 textureCoords;
+    vec4 tangent;
+
+    // Constructors
+    TangentVertex() = default;
+
+    TangentVertex(const Vertex& v, const vec4& t)
+        : pos(v.pos), normals(v.normals), textureCoords(v.textureCoords), tangent(t)
+    {}
+
+    // Util functions
+    vec3 bitangent() const
+    {
+        return vec3::cross(normals, tangent.xyz()) * tangent.w;
+    }
+};
+
+// Index storage that uses 16 bit indices whenever every vertex can be addressed with them.
+class IndexBuffer
+{
+    private:
+        std::variant<std::vector<uint16_t>, std::vector<uint32_t>> storage;
+
+    public:
+        IndexBuffer() {};
+
+        IndexBuffer(const std::vector<unsigned int>& indices, size_t vertexCount)
+        {
+            if (vertexCount <= 65536)
+            {
+                storage = std::vector<uint16_t>(indices.begin(), indices.end());
+            }
+            else
+            {
+                storage = std::vector<uint32_t>(indices.begin(), indices.end());
+            }
+        };
+
+        bool is16Bit() const
+        {
+            return std::holds_alternative<std::vector<uint16_t>>(storage);
+        }
+
+        size_t size() const
+        {
+            return std::visit([](const auto& v) { return v.size(); }, storage);
+        }
+
+        size_t byteSize() const
+        {
+            return is16Bit() ? size() * sizeof(uint16_t) : size() * sizeof(uint32_t);
+        }
+
+        unsigned int operator[](size_t i) const
+        {
+            return std::visit([i](const auto& v) { return (unsigned int)v[i]; }, storage);
+        }
+
+        const uint16_t* data16() const
+        {
+            const auto* v = std::get_if<std::vector<uint16_t>>(&storage);
+            return v ? v->data() : nullptr;
+        }
+
+        const uint32_t* data32() const
+        {
+            const auto* v = std::get_if<std::vector<uint32_t>>(&storage);
+            return v ? v->data() : nullptr;
+        }
+
+        std::vector<unsigned int> widen() const
+        {
+            return std::visit([](const auto& v) { return std::vector<unsigned int>(v.begin(), v.end()); }, storage);
+        }
+
+        void clear()
+        {
+            storage = std::vector<uint16_t>();
+        }
+};
+
+class MaterialLibrary;
+
+// Contiguous range of the index buffer whose triangles share an object, group and material.
+struct Submesh
+{
+    std::string object;
+    std::string group;
+    std::string material;
+    size_t indexOffset;
+    size_t indexCount;
+};
+
 class Mesh
 {
+	private:
+		// The 32 bit indices loaders and post-processing stages work on, empty while packed.
+		std::vector<unsigned int> workingIndices;
+
+		// Compact copy of the indices while the mesh is at rest.
+		IndexBuffer packed;
+
 	public:
 		std::vector<Vertex> vertices;
-		std::vector<unsigned int> indices;
+		std::vector<unsigned int> smoothingGroups; // one per triangle, empty when the file has no 's' statements
+		std::vector<Submesh> submeshes; // one per object/group/material, empty when the file has no 'o', 'g' or 'usemtl' statements
+		std::shared_ptr<const MaterialLibrary> materials; // from the 'mtllib' files, null when the loader does not read them
 
         // Constructors
 		Mesh() {};
@@ -187,22 +348,199 @@ class Mesh
 		Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
 		{
 			this->vertices = vertices;
-			this->indices = indices;
+			this->workingIndices = indices;
+		};
+
+		Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<unsigned int> smoothingGroups)
+		{
+			this->vertices = vertices;
+			this->workingIndices = indices;
+			this->smoothingGroups = smoothingGroups;
 		};
 
 		~Mesh() {};
+
+		// The 32 bit indices for code that builds or edits them; a packed mesh is unpacked first, so
+		// this never shows a packed mesh as empty. Readers of a const mesh use indexCount, index and
+		// visitIndices, which work in either form.
+		std::vector<unsigned int>& indices()
+		{
+			unpackIndices();
+			return workingIndices;
+		}
+
+		// Moves indices into the compact buffer, picking 16 bit storage when the vertex count allows it.
+		void packIndices()
+		{
+			if (workingIndices.empty()) return;
+
+			packed = IndexBuffer(workingIndices, vertices.size());
+			std::vector<unsigned int>().swap(workingIndices);
+		}
+
+		// Restores the 32 bit working indices that the post-processing stages edit in place.
+		void unpackIndices()
+		{
+			if (!workingIndices.empty() || packed.size() == 0) return;
+
+			workingIndices = packed.widen();
+			packed.clear();
+		}
+
+		bool isPacked() const
+		{
+			return workingIndices.empty() && packed.size() > 0;
+		}
+
+		bool has16BitIndices() const
+		{
+			return isPacked() && packed.is16Bit();
+		}
+
+		size_t indexCount() const
+		{
+			return isPacked() ? packed.size() : workingIndices.size();
+		}
+
+		size_t indexBytes() const
+		{
+			return isPacked() ? packed.byteSize() : workingIndices.size() * sizeof(unsigned int);
+		}
+
+		unsigned int index(size_t i) const
+		{
+			return isPacked() ? packed[i] : workingIndices[i];
+		}
+
+		// Calls function(pointer, count) with whichever array currently holds the indices.
+		template <typename Function>
+		void visitIndices(Function function) const
+		{
+			if (!isPacked()) function(workingIndices.data(), workingIndices.size());
+			else if (packed.is16Bit()) function(packed.data16(), packed.size());
+			else function(packed.data32(), packed.size());
+		}
+};
+
+// Named values a loader or stage reports on top of its timing.
+typedef std::vector<std::pair<const char*, double>> MetricList;
+
+struct StageResult
+{
+    const char* stageName;
+    std::chrono::microseconds elapsed;
+    size_t bytesProcessed;
+    MetricList metrics;
+};
+
+// Parts of a load a loader can report separately. Parse is for code that reads attributes and faces
+// in one call, such as the wrapped libraries.
+enum class LoadPhase { OpenMap, Scan, AttributeParse, FaceParse, Parse, Dedup, Assembly, WrapperConversion, Count };
+
+static const char* loadPhaseName(LoadPhase phase)
+{
+    switch (phase)
+    {
+        case LoadPhase::OpenMap: return "open/map";
+        case LoadPhase::Scan: return "scan";
+        case LoadPhase::AttributeParse: return "attribute parse";
+        case LoadPhase::FaceParse: return "face parse";
+        case LoadPhase::Parse: return "parse";
+        case LoadPhase::Dedup: return "dedup";
+        case LoadPhase::Assembly: return "mesh assembly";
+        case LoadPhase::WrapperConversion: return "wrapper conversion";
+        default: return "unknown";
+    }
+}
+
+struct PhaseTimes
+{
+    std::chrono::nanoseconds elapsed[(size_t)LoadPhase::Count] = {};
+
+    void add(const PhaseTimes& other)
+    {
+        for (size_t p = 0; p < (size_t)LoadPhase::Count; ++p)
+        {
+            elapsed[p] += other.elapsed[p];
+        }
+    }
+};
+
+// Hardware events counted around a load, see PerfCounterSession.
+enum class PerfCounter { Cycles, Instructions, BranchMisses, L1dMisses, LlcMisses, DtlbMisses, Count };
+
+struct PerfCounterValues
+{
+    uint64_t values[(size_t)PerfCounter::Count] = {};
+    bool valid[(size_t)PerfCounter::Count] = {}; // false when the counter could not be opened or never ran
+
+    void add(const PerfCounterValues& other)
+    {
+        for (size_t c = 0; c < (size_t)PerfCounter::Count; ++c)
+        {
+            if (!other.valid[c]) continue;
+
+            values[c] += other.values[c];
+            valid[c] = true;
+        }
+    }
+
+    bool has(PerfCounter counter) const
+    {
+        return valid[(size_t)counter];
+    }
+
+    double get(PerfCounter counter) const
+    {
+        return (double)values[(size_t)counter];
+    }
+};
+
+// Heap traffic and footprint of one load. Allocation counts stay zero unless the allocation hook is
+// linked in; peak RSS growth is how far the load raised the process high-water mark.
+struct MemoryUsage
+{
+    size_t allocations = 0;
+    size_t allocatedBytes = 0;
+    size_t freedBytes = 0;
+    size_t peakHeapBytes = 0;
+    size_t peakRssGrowth = 0;
+
+    void add(const MemoryUsage& other)
+    {
+        allocations += other.allocations;
+        allocatedBytes += other.allocatedBytes;
+        freedBytes += other.freedBytes;
+        peakHeapBytes = std::max(peakHeapBytes, other.peakHeapBytes);
+        peakRssGrowth += other.peakRssGrowth;
+    }
 };
 
 struct Result
 {
     Mesh mesh;
     std::chrono::milliseconds elapsed;
+    std::vector<StageResult> stages;
+    PhaseTimes phases;
+    PerfCounterValues counters;
+    size_t inputBytes = 0;
+    MemoryUsage memory;
+    std::string path;
 };
 
 struct Results
 {
     const char* implementationName;
     std::vector<Result> data;
+    MetricList metrics;
+};
+
+struct StageSummary
+{
+    const char* name;
+    std::chrono::microseconds totalTime;
+    size_t totalBytes;
+    MetricList averageMetrics;
 };
 
 struct ImplSummary
@@ -211,8 +549,12 @@ struct ImplSummary
     size_t totalVertices;
     size_t totalIndices;
     std::chrono::milliseconds totalTime;
+    std::vector<StageSummary> stages;
+    MetricList metrics;
+    PhaseTimes phases;
 };
 
+#ifdef _WIN32
 struct MappedFile {
     HANDLE file = INVALID_HANDLE_VALUE;
     HANDLE mapping = nullptr;
@@ -256,4 +598,41 @@ struct MappedFile {
     ~MappedFile() {
         close();
     }
-};
\ No newline at end of file
+};
+#else
+struct MappedFile {
+    int file = -1;
+    const char* data = nullptr;
+    size_t size = 0;
+
+    // Like MapViewOfFile, mapping an empty file fails.
+    bool open(const std::string& path) {
+        file = ::open(path.c_str(), O_RDONLY);
+
+        if (file < 0)
+            return false;
+
+        struct stat status;
+        if (fstat(file, &status) != 0)
+            return false;
+
+        size = (size_t)status.st_size;
+
+        void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view == MAP_FAILED)
+            return false;
+
+        data = (const char*)view;
+        return true;
+    }
+
+    void close() {
+        if (data) munmap((void*)data, size);
+        if (file >= 0) ::close(file);
+    }
+
+    ~MappedFile() {
+        close();
+    }
+};
+#endif
\ No newline at end of file